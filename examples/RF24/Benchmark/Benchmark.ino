@@ -0,0 +1,77 @@
+/*
+ * See License information at root directory of this library
+ */
+
+/**
+ * Throughput & latency benchmark across data rate, payload size, dynamic payloads, auto-ack, ACK payloads,
+ * CRC length, encryption and retries.
+ *
+ * Run this sketch on 2 devices. Both start as the receiving node, send a 'T' over Serial to one of them to
+ * start the sweep. It prints one CSV line per configuration (see benchmark.h), save the output to compare
+ * releases against each other. The same matrix runs on a PC with extras/host_sim/examples/benchmark.cpp
+ */
+#include "nrf_to_nrf.h"
+#include "benchmark.h"
+
+nrf_to_nrf radio;
+
+bool role = false;  // true = TX role, false = RX role
+
+void setup() {
+
+  Serial.begin(115200);
+  while (!Serial) {
+    // some boards need to wait to ensure access to serial over USB
+  }
+
+  if (!benchBegin(radio, false)) {
+    Serial.println(F("radio hardware is not responding!!"));
+    while (1) {}  // hold in infinite loop
+  }
+
+  Serial.println(F("RF24/examples/Benchmark"));
+  Serial.println(F("*** PRESS 'T' to run the benchmark from this node"));
+}  // setup
+
+void loop() {
+
+  if (role) {
+    // This device drives the benchmark
+
+    char line[128];
+    Serial.println(benchHeader());
+    for (uint16_t index = 0; index < BENCH_CONFIG_COUNT; index++) {
+      bench_result_t result;
+      bench_config_t cfg;
+      if (!benchGetConfig(index, &cfg)) {
+        continue;
+      }
+      if (benchRunTx(radio, index, &result)) {
+        benchFormatResult(line, sizeof(line), index, &result);
+        Serial.println(line);
+      } else {
+        Serial.print(F("# "));
+        Serial.print(index);
+        Serial.println(F(" no response from the receiving node"));
+      }
+    }
+    Serial.println(F("# done"));
+
+    // Go back to being the receiving node
+    role = false;
+    benchSetRole(radio, false);
+
+  } else {
+    // This device is the receiving node
+
+    benchRxLoop(radio);
+  }
+
+  if (Serial.available()) {
+    char c = toupper(Serial.read());
+    if (c == 'T' && !role) {
+      role = true;
+      benchSetRole(radio, true);
+    }
+  }
+}  // loop
@@ -0,0 +1,365 @@
+/*
+ * See License information at root directory of this library
+ */
+
+/**
+ * Benchmark matrix shared by Benchmark.ino and the host simulator runner (extras/host_sim/examples/benchmark.cpp).
+ *
+ * The transmitting node steps through every configuration. Before each run it tells the receiving node which
+ * configuration comes next, using a fixed control configuration. Both nodes then switch, the transmitter sends
+ * as fast as it can for BENCH_RUN_MS and both switch back. The receiver's packet count for the run is returned
+ * to the transmitter in an ACK payload.
+ */
+#ifndef __NRF_TO_NRF_BENCHMARK_H__
+#define __NRF_TO_NRF_BENCHMARK_H__
+
+#include "nrf_to_nrf.h"
+
+// How long each configuration is measured for
+#ifndef BENCH_RUN_MS
+  #define BENCH_RUN_MS 1000
+#endif
+
+// Time allowed for both nodes to switch back to the control configuration after a run
+#ifndef BENCH_GUARD_MS
+  #define BENCH_GUARD_MS 20
+#endif
+
+// write() latency histogram, 4us buckets up to ~4ms, slower writes are counted in the last bucket
+#define BENCH_BUCKET_US 4
+#define BENCH_BUCKETS   1024
+
+#define BENCH_MAX_PAYLOAD 32
+#define BENCH_CCM_OVERHEAD 12  // IV, counter & MIC added to encrypted payloads
+#define BENCH_MAGIC 0xB7
+#define BENCH_REPORT 0xFFFF  // Control index asking for the receiver's count, no run follows
+
+typedef struct {
+  uint8_t dataRate;
+  uint8_t payloadSize;
+  bool dynamicPayloads;
+  bool autoAck;
+  bool ackPayloads;
+  uint8_t crcLength;
+  bool encryption;
+  uint8_t retries;
+} bench_config_t;
+
+typedef struct {
+  uint32_t durationMs;
+  uint32_t sent;
+  uint32_t acked;
+  uint32_t received;          // Counted by the receiving node
+  uint32_t packetsPerSecond;  // ACKed packets, or received packets without auto-ack
+  uint32_t goodput;           // Payload bytes per second of the packets above
+  uint32_t p50;               // write() latency in us, with auto-ack this is the packet & ACK round trip
+  uint32_t p99;
+  uint32_t max;
+} bench_result_t;
+
+typedef struct {
+  uint8_t magic;
+  uint8_t reserved;
+  uint16_t index;
+} bench_control_t;
+
+static const uint8_t benchDataRates[] = { NRF_250KBPS, NRF_1MBPS, NRF_2MBPS
+#ifdef ARDUINO_NRF54L15
+                                          ,
+                                          NRF_4MBPS_OBT6
+#endif
+};
+static const uint8_t benchPayloadSizes[] = { 4, 16, BENCH_MAX_PAYLOAD };
+static const uint8_t benchRetries[] = { 0, 5 };
+
+// Every combination of the settings below, benchGetConfig() skips the ones that are not valid
+#define BENCH_CONFIG_COUNT (sizeof(benchDataRates) * sizeof(benchPayloadSizes) * sizeof(benchRetries) * 32)
+
+static const bench_config_t benchControlConfig = { NRF_1MBPS, sizeof(bench_control_t), true, true, true, NRF_CRC_16, false, 15 };
+
+static uint8_t benchAddress[][6] = { "1Node", "2Node" };
+static uint8_t benchKey[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+
+static uint32_t benchHistogram[BENCH_BUCKETS];
+
+static bool benchRxRunning = false;
+static uint32_t benchRxStart;
+static uint32_t benchRxReceived;
+static bench_config_t benchRxConfig;
+
+/**
+ * Decode a configuration index (0 to BENCH_CONFIG_COUNT - 1)
+ * @return false if the combination is not valid, ex: ACK payloads without auto-ack
+ */
+bool benchGetConfig(uint16_t index, bench_config_t* cfg) {
+  if (index >= BENCH_CONFIG_COUNT) {
+    return false;
+  }
+  cfg->retries = benchRetries[index % sizeof(benchRetries)];
+  bool retriesSet = index % sizeof(benchRetries);
+  index /= sizeof(benchRetries);
+  cfg->encryption = index & 1;
+  cfg->crcLength = (index & 2) ? NRF_CRC_16 : NRF_CRC_8;
+  cfg->ackPayloads = index & 4;
+  cfg->autoAck = index & 8;
+  cfg->dynamicPayloads = index & 16;
+  index /= 32;
+  cfg->payloadSize = benchPayloadSizes[index % sizeof(benchPayloadSizes)];
+  index /= sizeof(benchPayloadSizes);
+  cfg->dataRate = benchDataRates[index];
+
+  if (cfg->ackPayloads && (!cfg->autoAck || !cfg->dynamicPayloads)) {
+    return false;
+  }
+  if (retriesSet && !cfg->autoAck) {
+    return false;
+  }
+#if !defined CCM_ENCRYPTION_ENABLED
+  if (cfg->encryption) {
+    return false;
+  }
+#endif
+  return true;
+}
+
+/**
+ * Data rate in kbps, for reporting
+ */
+uint16_t benchDataRateKbps(uint8_t dataRate) {
+  if (dataRate == NRF_250KBPS) {
+    return 250;
+  }
+  if (dataRate == NRF_1MBPS) {
+    return 1000;
+  }
+  if (dataRate == NRF_2MBPS) {
+    return 2000;
+  }
+  return 4000;
+}
+
+/**
+ * Apply a configuration and go to TX (tx = true) or RX mode
+ */
+void benchApply(nrf_to_nrf& radio, const bench_config_t* cfg, bool tx) {
+  radio.setDataRate(cfg->dataRate);
+  radio.setCRCLength((nrf_crclength_e)cfg->crcLength);
+  radio.setRetries(5, cfg->retries);
+  radio.setAutoAck(cfg->autoAck);
+  uint8_t overhead = cfg->encryption ? BENCH_CCM_OVERHEAD : 0;
+  if (cfg->dynamicPayloads) {
+    radio.disableDynamicPayloads();
+    radio.enableDynamicPayloads(BENCH_MAX_PAYLOAD + BENCH_CCM_OVERHEAD);
+  } else {
+    radio.setPayloadSize(cfg->payloadSize + overhead);
+  }
+  if (cfg->ackPayloads) {
+    radio.enableAckPayload();
+  } else {
+    radio.disableAckPayload();
+  }
+#if defined CCM_ENCRYPTION_ENABLED
+  radio.enableEncryption = cfg->encryption;
+#endif
+  radio.flush_rx();
+  if (tx) {
+    radio.stopListening();
+  } else {
+    radio.startListening();
+  }
+}
+
+/**
+ * Become the transmitting (tx = true) or receiving node, in the control configuration
+ */
+void benchSetRole(nrf_to_nrf& radio, bool tx) {
+  radio.openWritingPipe(benchAddress[tx]);
+  radio.openReadingPipe(1, benchAddress[!tx]);
+  benchApply(radio, &benchControlConfig, tx);
+  if (!tx) {
+    benchRxRunning = false;
+    benchRxReceived = 0;
+    radio.flush_tx();
+    radio.writeAckPayload(1, &benchRxReceived, sizeof(benchRxReceived));
+  }
+}
+
+/**
+ * Set up a node, call once from setup()
+ */
+bool benchBegin(nrf_to_nrf& radio, bool tx) {
+  if (!radio.begin()) {
+    return false;
+  }
+  radio.setPALevel(NRF_PA_LOW);
+#if defined CCM_ENCRYPTION_ENABLED
+  radio.setKey(benchKey);
+#endif
+  benchSetRole(radio, tx);
+  return true;
+}
+
+/**
+ * Send a control packet, the receiver's packet count from the last run comes back in the ACK payload
+ */
+bool benchControl(nrf_to_nrf& radio, uint16_t index, uint32_t* received) {
+  bench_control_t control = { BENCH_MAGIC, 0, index };
+
+  // If the receiver got the packet but the ACK was lost, it is busy with the run until it times out
+  uint32_t start = millis();
+  while (millis() - start < BENCH_RUN_MS + 3 * BENCH_GUARD_MS) {
+    if (radio.write(&control, sizeof(control))) {
+      uint8_t len, pipe;
+      const uint8_t* data;
+      while ((data = radio.peek(&len, &pipe)) != NULL) {
+        if (len == sizeof(*received)) {
+          memcpy(received, data, sizeof(*received));
+        }
+        radio.release();
+      }
+      return true;
+    }
+    delay(5);
+  }
+  return false;
+}
+
+/**
+ * Percentile of the write() latency histogram
+ */
+uint32_t benchPercentile(uint32_t count, uint8_t percent, uint32_t maxLatency) {
+  uint32_t target = (count * percent + 99) / 100;
+  uint32_t total = 0;
+  for (uint16_t i = 0; i < BENCH_BUCKETS; i++) {
+    total += benchHistogram[i];
+    if (total >= target && total) {
+      return min((uint32_t)(i + 1) * BENCH_BUCKET_US, maxLatency);
+    }
+  }
+  return maxLatency;
+}
+
+/**
+ * Measure one configuration from the transmitting node
+ * @return false if the index is not a valid configuration or the receiver did not respond
+ */
+bool benchRunTx(nrf_to_nrf& radio, uint16_t index, bench_result_t* result) {
+  bench_config_t cfg;
+  if (!benchGetConfig(index, &cfg)) {
+    return false;
+  }
+  memset(result, 0, sizeof(*result));
+  memset(benchHistogram, 0, sizeof(benchHistogram));
+
+  uint32_t unused;
+  if (!benchControl(radio, index, &unused)) {
+    return false;
+  }
+  benchApply(radio, &cfg, true);
+
+  uint8_t payload[BENCH_MAX_PAYLOAD];
+  memset(payload, 0xA5, sizeof(payload));
+  uint32_t start = millis();
+  while (millis() - start < BENCH_RUN_MS) {
+    memcpy(payload, &result->sent, sizeof(result->sent));
+    uint32_t timer = micros();
+    bool ok = radio.write(payload, cfg.payloadSize);
+    uint32_t latency = micros() - timer;
+
+    result->sent++;
+    if (ok) {
+      result->acked++;
+    }
+    benchHistogram[min(latency / BENCH_BUCKET_US, (uint32_t)BENCH_BUCKETS - 1)]++;
+    result->max = max(result->max, latency);
+    // Discard the ACK payloads
+    radio.flush_rx();
+  }
+  result->durationMs = millis() - start;
+
+  delay(2 * BENCH_GUARD_MS);
+  benchApply(radio, &benchControlConfig, true);
+  if (!benchControl(radio, BENCH_REPORT, &result->received)) {
+    return false;
+  }
+
+  uint32_t delivered = cfg.autoAck ? result->acked : min(result->received, result->sent);
+  result->packetsPerSecond = (uint64_t)delivered * 1000 / result->durationMs;
+  result->goodput = (uint64_t)delivered * cfg.payloadSize * 1000 / result->durationMs;
+  result->p50 = benchPercentile(result->sent, 50, result->max);
+  result->p99 = benchPercentile(result->sent, 99, result->max);
+  return true;
+}
+
+/**
+ * Call from loop() on the receiving node
+ */
+void benchRxLoop(nrf_to_nrf& radio) {
+  uint8_t len, pipe;
+  const uint8_t* data;
+
+  if (benchRxRunning) {
+    while (radio.available()) {
+      data = radio.peek(&len, &pipe);
+      benchRxReceived++;
+      if (benchRxConfig.ackPayloads) {
+        radio.writeAckPayload(1, (void*)data, len);
+      }
+      radio.release();
+    }
+    if (millis() - benchRxStart > BENCH_RUN_MS + BENCH_GUARD_MS) {
+      benchRxRunning = false;
+      benchApply(radio, &benchControlConfig, false);
+      // Drop the ACK payloads left from the run, the count goes with the next control packet's ACK
+      radio.flush_tx();
+      radio.writeAckPayload(1, &benchRxReceived, sizeof(benchRxReceived));
+    }
+    return;
+  }
+
+  while (radio.available()) {
+    bench_control_t control;
+    data = radio.peek(&len, &pipe);
+    bool isControl = len == sizeof(control);
+    if (isControl) {
+      memcpy(&control, data, sizeof(control));
+    }
+    radio.release();
+    if (isControl && control.magic == BENCH_MAGIC && benchGetConfig(control.index, &benchRxConfig)) {
+      benchRxReceived = 0;
+      benchRxStart = millis();
+      benchRxRunning = true;
+      benchApply(radio, &benchRxConfig, false);
+      // Drop the count, it is not encrypted & has the wrong size
+      radio.flush_tx();
+      if (benchRxConfig.ackPayloads) {
+        uint8_t payload[BENCH_MAX_PAYLOAD] = { 0 };
+        radio.writeAckPayload(1, payload, benchRxConfig.payloadSize);
+      }
+      return;
+    }
+  }
+}
+
+/**
+ * CSV column names for benchFormatResult()
+ */
+const char* benchHeader() {
+  return "index,rate_kbps,payload,dpl,auto_ack,ack_payload,crc_bytes,encryption,retries,sent,acked,received,"
+         "packets_per_s,goodput_Bps,p50_us,p99_us,max_us";
+}
+
+/**
+ * Format a result as one CSV line
+ */
+void benchFormatResult(char* buffer, size_t size, uint16_t index, const bench_result_t* result) {
+  bench_config_t cfg;
+  benchGetConfig(index, &cfg);
+  snprintf(buffer, size, "%u,%u,%u,%u,%u,%u,%u,%u,%u,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu", index, benchDataRateKbps(cfg.dataRate),
+           cfg.payloadSize, cfg.dynamicPayloads, cfg.autoAck, cfg.ackPayloads, cfg.crcLength, cfg.encryption, cfg.retries,
+           (unsigned long)result->sent, (unsigned long)result->acked, (unsigned long)result->received,
+           (unsigned long)result->packetsPerSecond, (unsigned long)result->goodput, (unsigned long)result->p50,
+           (unsigned long)result->p99, (unsigned long)result->max);
+}
+
+#endif  // __NRF_TO_NRF_BENCHMARK_H__
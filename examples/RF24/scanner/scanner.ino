@@ -38,6 +38,7 @@ nrf_to_nrf radio;
 
 const uint8_t num_channels = 100;
 uint8_t values[num_channels];
+nrf_scan_result_t results[num_channels];
 
 //
 // Setup
@@ -114,18 +115,13 @@ void loop(void) {
     // Scan all channels num_reps times
     int rep_counter = num_reps;
     while (rep_counter--) {
+      // Sweep the channels, 4 RSSI samples each
+      radio.scanChannels(0, num_channels - 1, results, 4);
+
       int i = num_channels;
       while (i--) {
-        // Select this channel
-        radio.setChannel(i);
-
-        // Listen for a little
-        radio.startListening();
-        delayMicroseconds(128);
-        //radio.stopListening();
-
-        // Did we get a carrier?
-        if (radio.testCarrier()) {
+        // Did we get a carrier? (better than -65dBm, like testCarrier())
+        if (results[i].peak < 65) {
           ++values[i];
         }
       }
@@ -0,0 +1,100 @@
+/**
+ * @file Arduino.h
+ *
+ * Minimal Arduino API for building nrf_to_nrf & sketches against the host side peripheral model (nrf_sim.h)
+ */
+#ifndef __NRF_SIM_ARDUINO_H__
+#define __NRF_SIM_ARDUINO_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include "nrf_sim.h"
+
+// The modelled chip is an nRF52840
+#ifndef NRF52840_XXAA
+    #define NRF52840_XXAA
+#endif
+
+// Each node runs on its own thread, so the library's interrupt handler instance pointers must be per thread
+#define NRF_ISR_INSTANCE static thread_local
+
+// There is no DWT, NRF_CYCLE_STATS counts cycles of a 64MHz core on the node's virtual clock
+#define NRF_CYCLE_CLOCK() ((uint32_t)(nrf_sim::now() * 64))
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HEX 16
+#define DEC 10
+#define OCT 8
+#define BIN 2
+
+#ifndef min
+    #define min(a, b) ((a) < (b) ? (a) : (b))
+#endif
+#ifndef max
+    #define max(a, b) ((a) > (b) ? (a) : (b))
+#endif
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define F(string_literal)         (string_literal)
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield(void);
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+
+/**
+ * Serial output goes to stdout, with each line prefixed by the number of the node that printed it
+ */
+class SimSerial
+{
+public:
+    void begin(unsigned long) {}
+    void end() {}
+    operator bool() { return true; }
+    int available() { return 0; }
+    int read() { return -1; }
+    void flush() { fflush(stdout); }
+
+    size_t write(uint8_t c);
+    size_t print(const char* str);
+    size_t print(char c);
+    size_t print(unsigned char n, int base = DEC) { return printNumber(n, base, false); }
+    size_t print(int n, int base = DEC) { return printSigned(n, base); }
+    size_t print(unsigned int n, int base = DEC) { return printNumber(n, base, false); }
+    size_t print(long n, int base = DEC) { return printSigned(n, base); }
+    size_t print(unsigned long n, int base = DEC) { return printNumber(n, base, false); }
+    size_t print(long long n, int base = DEC) { return printSigned(n, base); }
+    size_t print(unsigned long long n, int base = DEC) { return printNumber(n, base, false); }
+    size_t print(double n, int digits = 2);
+
+    template<typename T>
+    size_t println(T value)
+    {
+        size_t n = print(value);
+        return n + print('\n');
+    }
+    template<typename T>
+    size_t println(T value, int format)
+    {
+        size_t n = print(value, format);
+        return n + print('\n');
+    }
+    size_t println() { return print('\n'); }
+    size_t printf(const char* format, ...);
+
+private:
+    size_t printSigned(long long n, int base);
+    size_t printNumber(unsigned long long n, int base, bool negative);
+};
+
+extern SimSerial Serial;
+
+#endif // __NRF_SIM_ARDUINO_H__
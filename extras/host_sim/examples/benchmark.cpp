@@ -0,0 +1,141 @@
+/*
+ * Runs the examples/RF24/Benchmark matrix between two simulated nRF52s and prints one CSV line per configuration.
+ *
+ *   benchmark > baseline.csv
+ *   benchmark --baseline baseline.csv [--tolerance 10] [--loss 0]
+ *
+ * With --baseline, packets/s below or p99 latency above the baseline by more than the tolerance (in percent) is
+ * reported as a regression and the exit code is 1. See ../README.md for how to build.
+ */
+#ifndef BENCH_RUN_MS
+    #define BENCH_RUN_MS 200
+#endif
+#include "../../../examples/RF24/Benchmark/benchmark.h"
+
+// Radios must be globals, EasyDMA pointers are only 32 bits
+nrf_to_nrf radioTx;
+nrf_to_nrf radioRx;
+
+struct BenchRow
+{
+    bool valid;
+    uint32_t packetsPerSecond;
+    uint32_t p99;
+};
+
+BenchRow results[BENCH_CONFIG_COUNT];
+uint16_t nextIndex = 0;
+uint16_t failures = 0;
+
+void txSetup()
+{
+    benchBegin(radioTx, true);
+}
+
+void txLoop()
+{
+    while (nextIndex < BENCH_CONFIG_COUNT) {
+        uint16_t index = nextIndex++;
+        bench_config_t cfg;
+        if (!benchGetConfig(index, &cfg)) {
+            continue;
+        }
+        bench_result_t result;
+        if (!benchRunTx(radioTx, index, &result)) {
+            printf("# %u no response from the receiving node\n", index);
+            failures++;
+            return;
+        }
+        char line[128];
+        benchFormatResult(line, sizeof(line), index, &result);
+        printf("%s\n", line);
+        results[index] = BenchRow { true, result.packetsPerSecond, result.p99 };
+        return;
+    }
+    nrf_sim::stop();
+}
+
+void rxSetup()
+{
+    benchBegin(radioRx, false);
+}
+
+void rxLoop()
+{
+    benchRxLoop(radioRx);
+}
+
+// Compare against a previous run, lines that do not start with an index (header, comments) are skipped
+int compareBaseline(const char* path, float tolerance)
+{
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "can't open %s\n", path);
+        return 1;
+    }
+    int regressions = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        unsigned long values[17];
+        int count = 0;
+        char* field = line;
+        if (*field < '0' || *field > '9') {
+            continue;
+        }
+        while (count < 17 && field) {
+            values[count++] = strtoul(field, NULL, 10);
+            field = strchr(field, ',');
+            field = field ? field + 1 : NULL;
+        }
+        uint16_t index = values[0];
+        if (count < 17 || index >= BENCH_CONFIG_COUNT || !results[index].valid) {
+            continue;
+        }
+        unsigned long pps = values[12];
+        unsigned long p99 = values[15];
+        if (results[index].packetsPerSecond < pps * (1.0f - tolerance / 100.0f)) {
+            printf("# regression %u: %u packets/s, baseline %lu\n", index, results[index].packetsPerSecond, pps);
+            regressions++;
+        }
+        if (results[index].p99 > p99 * (1.0f + tolerance / 100.0f)) {
+            printf("# regression %u: p99 %uus, baseline %luus\n", index, results[index].p99, p99);
+            regressions++;
+        }
+    }
+    fclose(file);
+    printf("# %d regressions against %s\n", regressions, path);
+    return regressions ? 1 : 0;
+}
+
+int main(int argc, char** argv)
+{
+    const char* baseline = NULL;
+    float tolerance = 10;
+    float loss = 0;
+    for (int i = 1; i < argc - 1; i += 2) {
+        if (!strcmp(argv[i], "--baseline")) {
+            baseline = argv[i + 1];
+        }
+        else if (!strcmp(argv[i], "--tolerance")) {
+            tolerance = atof(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--loss")) {
+            loss = atof(argv[i + 1]);
+        }
+    }
+
+    int tx = nrf_sim::addNode(txSetup, txLoop);
+    int rx = nrf_sim::addNode(rxSetup, rxLoop);
+    nrf_sim::setLinkLoss(tx, rx, loss);
+    nrf_sim::setLinkLoss(rx, tx, loss);
+
+    printf("%s\n", benchHeader());
+    // Generous upper bound, the TX node stops the simulation once it has been through the matrix
+    nrf_sim::run(BENCH_CONFIG_COUNT * (BENCH_RUN_MS * 2 + 5 * BENCH_GUARD_MS));
+
+    if (nextIndex < BENCH_CONFIG_COUNT || failures) {
+        printf("# incomplete: stopped at %u with %u failures\n", nextIndex, failures);
+        return 1;
+    }
+    return baseline ? compareBaseline(baseline, tolerance) : 0;
+}
@@ -0,0 +1,79 @@
+/*
+ * Two simulated nRF52s: node 0 sends a counter every 10ms with auto-ack & dynamic payloads, node 1 receives it
+ * and returns ACK payloads. See ../README.md for how to build & run.
+ */
+#include "nrf_to_nrf.h"
+
+// Radios must be globals, EasyDMA pointers are only 32 bits
+nrf_to_nrf radioTx;
+nrf_to_nrf radioRx;
+
+uint8_t address[][6] = { "1Node", "2Node" };
+
+uint32_t counter = 0;
+uint32_t sent = 0;
+uint32_t acked = 0;
+uint32_t ackPayloads = 0;
+uint32_t received = 0;
+
+void txSetup()
+{
+    radioTx.begin();
+    radioTx.enableDynamicPayloads();
+    radioTx.enableAckPayload();
+    radioTx.openWritingPipe(address[1]);
+    radioTx.openReadingPipe(1, address[0]);
+    radioTx.stopListening();
+}
+
+void txLoop()
+{
+    sent++;
+    if (radioTx.write(&counter, sizeof(counter))) {
+        acked++;
+        uint8_t pipe;
+        while (radioTx.available(&pipe)) {
+            uint32_t ack;
+            radioTx.read(&ack, sizeof(ack));
+            ackPayloads++;
+        }
+    }
+    counter++;
+    delay(10);
+}
+
+void rxSetup()
+{
+    radioRx.begin();
+    radioRx.enableDynamicPayloads();
+    radioRx.enableAckPayload();
+    radioRx.openWritingPipe(address[0]);
+    radioRx.openReadingPipe(1, address[1]);
+    radioRx.startListening();
+    uint32_t ack = 0;
+    radioRx.writeAckPayload(1, &ack, sizeof(ack));
+}
+
+void rxLoop()
+{
+    uint8_t pipe;
+    if (radioRx.available(&pipe)) {
+        uint32_t value;
+        radioRx.read(&value, sizeof(value));
+        received++;
+        radioRx.writeAckPayload(1, &value, sizeof(value));
+    }
+}
+
+int main()
+{
+    nrf_sim::addNode(txSetup, txLoop);
+    nrf_sim::addNode(rxSetup, rxLoop);
+    nrf_sim::run(1000);
+
+    nrf_sim::stats_t stats = nrf_sim::getStats();
+    printf("sent %u acked %u ack payloads %u received %u\n", sent, acked, ackPayloads, received);
+    printf("air: %u packets, %u received, %u CRC errors, %u collisions\n", stats.packetsSent, stats.packetsReceived,
+           stats.crcErrors, stats.collisions);
+    return acked == sent ? 0 : 1;
+}
@@ -0,0 +1,105 @@
+/*
+ * Burst loss of the RX FIFO: node 0 sends bursts of back-to-back packets to node 1, which takes BURST_READ_US to
+ * handle each packet it read()s, like a gateway forwarding to a slow link.
+ *
+ *   rx_burst [--retries <n>]
+ *
+ * Without --retries both nodes have auto-ack disabled, so every packet that finds no room is lost. With it the
+ * packets are ACKed & retried up to n times, the retransmissions show the cost instead. Build with
+ * -DNRF_RX_FIFO_SIZE=1/3/8 (and -DNRF_RADIO_IRQ_ENABLED) to compare depths. Without interrupts, packets only reach the
+ * FIFO from available(), -DBURST_POLL=1 keeps calling it while busy. See ../README.md for how to build.
+ */
+#include "nrf_to_nrf.h"
+
+#ifndef BURST_LENGTH
+    #define BURST_LENGTH 8
+#endif
+#ifndef BURST_COUNT
+    #define BURST_COUNT 50
+#endif
+#ifndef BURST_READ_US
+    #define BURST_READ_US 1000
+#endif
+#ifndef BURST_POLL
+    #define BURST_POLL 0
+#endif
+
+// Radios must be globals, EasyDMA pointers are only 32 bits
+nrf_to_nrf radioTx;
+nrf_to_nrf radioRx;
+
+uint8_t address[][6] = { "1Node", "2Node" };
+
+bool acks = false;
+uint8_t retries = 0;
+uint32_t sent = 0;
+uint32_t retransmits = 0;
+uint32_t received = 0;
+
+void txSetup()
+{
+    radioTx.begin();
+    radioTx.enableDynamicPayloads();
+    radioTx.setAutoAck(acks);
+    radioTx.setRetries(5, retries);
+    radioTx.openWritingPipe(address[1]);
+    radioTx.stopListening();
+}
+
+void txLoop()
+{
+    for (uint8_t i = 0; i < BURST_LENGTH; i++) {
+        sent++;
+        radioTx.write(&sent, sizeof(sent));
+        retransmits += radioTx.getARC();
+    }
+    // Long enough for the receiver to drain the FIFO between bursts
+    delay(BURST_LENGTH * BURST_READ_US / 1000 + 20);
+    if (sent >= BURST_LENGTH * BURST_COUNT) {
+        nrf_sim::stop();
+    }
+}
+
+void rxSetup()
+{
+    radioRx.begin();
+    radioRx.enableDynamicPayloads();
+    radioRx.setAutoAck(acks);
+    radioRx.openReadingPipe(1, address[1]);
+    radioRx.startListening();
+}
+
+void rxLoop()
+{
+    if (radioRx.available()) {
+        uint32_t value;
+        radioRx.read(&value, sizeof(value));
+        received++;
+        // Handle the packet, interrupts are still taken meanwhile (a single delay() would hold them back here)
+        uint32_t start = micros();
+        while (micros() - start < BURST_READ_US) {
+#if BURST_POLL
+            // A sketch that keeps polling the radio while busy, received packets are moved into the FIFO
+            radioRx.available();
+#endif
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    for (int i = 1; i < argc - 1; i += 2) {
+        if (!strcmp(argv[i], "--retries")) {
+            acks = true;
+            retries = atoi(argv[i + 1]);
+        }
+    }
+
+    nrf_sim::addNode(txSetup, txLoop);
+    nrf_sim::addNode(rxSetup, rxLoop);
+    nrf_sim::run(BURST_COUNT * (BURST_LENGTH * (BURST_READ_US / 1000 + 20) + 20) + 1000);
+
+    printf("fifo %u: sent %u, received %u, lost %u (%.1f%%), retransmits %u\n", NRF_RX_FIFO_SIZE, sent, received, sent - received,
+           100.0f * (sent - received) / sent, retransmits);
+    return 0;
+}
@@ -0,0 +1,1417 @@
+/**
+ * @file nrf_sim.cpp
+ *
+ * Host side model of the nRF52 peripherals used by nrf_to_nrf, see nrf_sim.h & README.md
+ */
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <vector>
+#include <stdarg.h>
+#include "Arduino.h"
+
+extern "C" {
+void RADIO_IRQHandler(void) __attribute__((weak));
+void RNG_IRQHandler(void) __attribute__((weak));
+void CCM_AAR_IRQHandler(void) __attribute__((weak));
+void TIMER0_IRQHandler(void) __attribute__((weak));
+void TIMER1_IRQHandler(void) __attribute__((weak));
+void TIMER2_IRQHandler(void) __attribute__((weak));
+}
+
+namespace {
+
+const uint64_t US = 1000; // The virtual clock runs in nanoseconds
+
+// Nodes may run this far ahead of the node with the lowest virtual time before handing over
+const uint64_t SYNC_QUANTUM = 5 * US;
+
+const int NOISE_FLOOR_DBM = -100;
+
+struct StopRun
+{
+};
+
+struct Packet
+{
+    int src;
+    uint32_t frequency;
+    uint32_t mode;
+    uint8_t prefix;
+    uint32_t base;
+    uint8_t balen;
+    uint64_t start;   // Start of the preamble
+    uint64_t addrEnd; // End of the address, receivers lock on here
+    uint64_t end;
+    bool aborted;
+    uint16_t crc;
+    std::vector<uint8_t> frame; // S0/LENGTH/S1 header & payload as read by EasyDMA
+};
+
+struct RadioModel
+{
+    uint32_t gen; // Incremented to cancel scheduled radio events
+    int txPacket;
+    int rxPacket;
+    uint64_t listenStart;
+    uint64_t lastRxEnd;
+    uint32_t rxPtr; // PACKETPTR latched at RX START
+};
+
+struct TimerModel
+{
+    bool running;
+    uint64_t startTime;
+    uint32_t base;
+    uint32_t gen;
+};
+
+struct Node
+{
+    nrf_sim_peripherals_t p;
+    RadioModel radio;
+    TimerModel timer[3];
+    TimerModel rtc[3];
+    bool rngRunning;
+    uint32_t rngGen;
+
+    void (*setup)(void);
+    void (*loop)(void);
+    std::thread thread;
+    bool active;
+    bool done;
+    uint64_t time;
+    uint32_t nvicEnabled;
+    bool inIsr;
+    bool lineStart;
+    uint64_t random;
+};
+
+Node nodes[NRF_SIM_MAX_NODES];
+int nodeCount = 0;
+
+std::mutex schedMutex;
+std::condition_variable schedCv;
+int current = -1;
+bool stopping = false;
+bool ran = false;
+uint64_t endTime = 0;
+uint64_t simNow = 0;
+uint64_t callCost = 1 * US;
+uint32_t seed = 1;
+
+std::multimap<uint64_t, std::function<void(uint64_t)>> events;
+std::map<int, Packet> air;
+int nextPacketId = 0;
+
+int linkRssi[NRF_SIM_MAX_NODES][NRF_SIM_MAX_NODES];
+float linkLoss[NRF_SIM_MAX_NODES][NRF_SIM_MAX_NODES];
+nrf_sim::stats_t stats;
+
+thread_local int self = -1;
+
+// Set NRF_SIM_TRACE in the environment to log radio activity to stderr
+bool trace = false;
+
+#define TRACE(t, n, ...)                                                                      \
+    if (trace) {                                                                              \
+        fprintf(stderr, "%10.3f [%d] ", (t) / 1000.0, n);                                     \
+        fprintf(stderr, __VA_ARGS__);                                                         \
+        fputc('\n', stderr);                                                                  \
+    }
+
+/**************************************************************************************************************/
+
+uint64_t nextRandom(Node& nd)
+{
+    // splitmix64
+    uint64_t z = (nd.random += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+uint8_t* dmaPtr(uint32_t address)
+{
+    return (uint8_t*)(uintptr_t)address;
+}
+
+void schedule(uint64_t t, std::function<void(uint64_t)> fn)
+{
+    events.emplace(t, fn);
+}
+
+void processEvents(uint64_t upTo)
+{
+    while (!events.empty() && events.begin()->first <= upTo) {
+        auto it = events.begin();
+        uint64_t t = it->first;
+        std::function<void(uint64_t)> fn = it->second;
+        events.erase(it);
+        if (t > simNow) {
+            simNow = t;
+        }
+        fn(t);
+    }
+    if (upTo > simNow) {
+        simNow = upTo;
+    }
+
+    // Forget packets that can no longer collide with anything
+    while (!air.empty() && air.begin()->second.end + 10000 * US < simNow) {
+        air.erase(air.begin());
+    }
+}
+
+void triggerTask(const void* task, uint64_t t);
+
+void setEvent(Node& nd, volatile uint32_t* event, uint64_t t)
+{
+    *event = 1;
+    NRF_PPI_Type& ppi = nd.p.ppi;
+    uint32_t address = (uint32_t)(uintptr_t)event;
+    for (int ch = 0; ch < 20; ch++) {
+        if ((ppi.CHEN & (1UL << ch)) && ppi.CH[ch].EEP == address) {
+            if (ppi.CH[ch].TEP) {
+                triggerTask((const void*)(uintptr_t)ppi.CH[ch].TEP, t);
+            }
+            if (ppi.FORK[ch].TEP) {
+                triggerTask((const void*)(uintptr_t)ppi.FORK[ch].TEP, t);
+            }
+        }
+    }
+}
+
+/**************************************************************************************************************/
+// RADIO
+
+uint64_t byteTime(uint32_t mode)
+{
+    switch (mode & 0xF) {
+        case RADIO_MODE_MODE_Nrf_2Mbit: return 4 * US;
+        case RADIO_MODE_MODE_Nrf_250Kbit: return 32 * US;
+        default: return 8 * US;
+    }
+}
+
+uint64_t rampTime(Node& nd)
+{
+    return (nd.p.radio.MODECNF0 & 1) ? 40 * US : 130 * US;
+}
+
+void logicalAddress(NRF_RADIO_Type& r, uint8_t n, uint8_t* prefix, uint32_t* base)
+{
+    *base = n ? r.BASE1 : r.BASE0;
+    *prefix = n < 4 ? (r.PREFIX0 >> (8 * n)) & 0xFF : (r.PREFIX1 >> (8 * (n - 4))) & 0xFF;
+}
+
+// Header & payload length of a frame in RAM, per the PCNF0/PCNF1 settings of a radio
+void frameLayout(NRF_RADIO_Type& r, const uint8_t* ram, uint32_t* header, uint32_t* length)
+{
+    uint32_t s0 = (r.PCNF0 >> RADIO_PCNF0_S0LEN_Pos) & 1;
+    uint32_t lflen = (r.PCNF0 >> RADIO_PCNF0_LFLEN_Pos) & 0xF;
+    uint32_t s1len = (r.PCNF0 >> RADIO_PCNF0_S1LEN_Pos) & 0xF;
+    *header = s0 + (lflen ? 1 : 0) + (s1len ? 1 : 0);
+    if (lflen) {
+        *length = ram[s0] & ((1 << lflen) - 1);
+    }
+    else {
+        *length = (r.PCNF1 >> RADIO_PCNF1_STATLEN_Pos) & 0xFF;
+    }
+}
+
+uint16_t crc16(NRF_RADIO_Type& r, const std::vector<uint8_t>& frame)
+{
+    uint32_t bytes = r.CRCCNF & 3;
+    uint32_t bits = bytes * 8;
+    if (!bits) {
+        return 0;
+    }
+    uint32_t crc = r.CRCINIT & ((1UL << bits) - 1);
+    uint32_t poly = r.CRCPOLY & ((1UL << bits) - 1);
+    for (uint8_t b : frame) {
+        crc ^= (uint32_t)b << (bits - 8);
+        for (int i = 0; i < 8; i++) {
+            crc = (crc & (1UL << (bits - 1))) ? (crc << 1) ^ poly : crc << 1;
+        }
+        crc &= (1UL << bits) - 1;
+    }
+    return crc;
+}
+
+// Strongest signal on the radio's channel as seen by node n at time t
+int channelPower(int n, uint64_t from, uint64_t to)
+{
+    int dBm = NOISE_FLOOR_DBM;
+    uint32_t frequency = nodes[n].p.radio.FREQUENCY;
+    for (auto& it : air) {
+        Packet& q = it.second;
+        if (q.src != n && q.frequency == frequency && q.start <= to && q.end > from) {
+            dBm = max(dBm, linkRssi[q.src][n]);
+        }
+    }
+    return dBm;
+}
+
+void radioStart(int n, uint64_t t);
+void radioDisable(int n, uint64_t t);
+void radioTxEn(int n, uint64_t t);
+void radioRxEn(int n, uint64_t t);
+void radioStop(int n, uint64_t t);
+void radioRssiStart(int n, uint64_t t);
+void radioCcaStart(int n, uint64_t t);
+
+void radioReady(int n, uint64_t t, bool tx)
+{
+    Node& nd = nodes[n];
+    NRF_RADIO_Type& r = nd.p.radio;
+    r.STATE = tx ? RADIO_STATE_STATE_TxIdle : RADIO_STATE_STATE_RxIdle;
+    TRACE(t, n, "%s READY shorts 0x%X", tx ? "TX" : "RX", r.SHORTS);
+    setEvent(nd, &r.EVENTS_READY, t);
+    setEvent(nd, tx ? &r.EVENTS_TXREADY : &r.EVENTS_RXREADY, t);
+    if ((r.SHORTS & RADIO_SHORTS_READY_START_Msk) || (tx && (r.SHORTS & RADIO_SHORTS_TXREADY_START_Msk))
+        || (!tx && (r.SHORTS & RADIO_SHORTS_RXREADY_START_Msk))) {
+        radioStart(n, t);
+    }
+    if (!tx && (r.SHORTS & RADIO_SHORTS_RXREADY_CCASTART_Msk)) {
+        radioCcaStart(n, t);
+    }
+}
+
+void radioTxEn(int n, uint64_t t)
+{
+    Node& nd = nodes[n];
+    NRF_RADIO_Type& r = nd.p.radio;
+    if (r.STATE != RADIO_STATE_STATE_Disabled) {
+        return;
+    }
+    r.STATE = RADIO_STATE_STATE_TxRu;
+    uint32_t gen = ++nd.radio.gen;
+    uint64_t ready = t + rampTime(nd);
+    // When turning around from RX, TIFS sets the time between the received packet and the transmission
+    if (nd.radio.lastRxEnd + r.TIFS * US > ready) {
+        ready = nd.radio.lastRxEnd + r.TIFS * US;
+    }
+    schedule(ready, [n, gen](uint64_t t) {
+        if (nodes[n].radio.gen == gen) {
+            radioReady(n, t, true);
+        }
+    });
+}
+
+void radioRxEn(int n, uint64_t t)
+{
+    Node& nd = nodes[n];
+    NRF_RADIO_Type& r = nd.p.radio;
+    if (r.STATE != RADIO_STATE_STATE_Disabled) {
+        return;
+    }
+    r.STATE = RADIO_STATE_STATE_RxRu;
+    uint32_t gen = ++nd.radio.gen;
+    schedule(t + rampTime(nd), [n, gen](uint64_t t) {
+        if (nodes[n].radio.gen == gen) {
+            radioReady(n, t, false);
+        }
+    });
+}
+
+void radioRxEnd(int n, int id, uint64_t t)
+{
+    Node& nd = nodes[n];
+    NRF_RADIO_Type& r = nd.p.radio;
+    nd.radio.rxPacket = -1;
+    nd.radio.lastRxEnd = t;
+    r.STATE = RADIO_STATE_STATE_RxIdle;
+
+    Packet& p = air[id];
+    bool ok = !p.aborted;
+    for (auto& it : air) {
+        Packet& q = it.second;
+        if (it.first != id && q.src != n && q.frequency == p.frequency && q.start < p.end && q.end > p.start) {
+            stats.collisions++;
+            ok = false;
+            break;
+        }
+    }
+
+    // Write the frame to RAM as this radio's packet configuration sees it
+    uint32_t header, length;
+    frameLayout(r, p.frame.data(), &header, &length);
+    uint32_t maxLength = (r.PCNF1 >> RADIO_PCNF1_MAXLEN_Pos) & 0xFF;
+    if (length > maxLength) {
+        length = maxLength;
+        ok = false;
+    }
+    uint32_t size = min((uint32_t)p.frame.size(), header + length);
+    memcpy(dmaPtr(nd.radio.rxPtr), p.frame.data(), size);
+    if (size < header + length) {
+        // Sent with a shorter packet format than this radio expects
+        ok = false;
+    }
+
+    r.RXCRC = p.crc;
+    r.CRCSTATUS = ok;
+    TRACE(t, n, "RX END packet %d from %d, %u bytes, %s", id, p.src, size, ok ? "CRCOK" : "CRCERROR");
+    if (ok) {
+        stats.packetsReceived++;
+    }
+    else {
+        stats.crcErrors++;
+    }
+    setEvent(nd, &r.EVENTS_PAYLOAD, t);
+    setEvent(nd, &r.EVENTS_END, t);
+    setEvent(nd, &r.EVENTS_PHYEND, t);
+    setEvent(nd, ok ? &r.EVENTS_CRCOK : &r.EVENTS_CRCERROR, t);
+    if (r.SHORTS & RADIO_SHORTS_END_DISABLE_Msk) {
+        radioDisable(n, t);
+    }
+    else if (r.SHORTS & RADIO_SHORTS_END_START_Msk) {
+        radioStart(n, t);
+    }
+}
+
+// The address of packet id has been sent, let any radio listening for it lock on
+void airAddress(int id, uint64_t t)
+{
+    Packet& p = air[id];
+    if (p.aborted) {
+        return;
+    }
+    for (int m = 0; m < nodeCount; m++) {
+        Node& nd = nodes[m];
+        NRF_RADIO_Type& r = nd.p.radio;
+        if (m == p.src || r.STATE != RADIO_STATE_STATE_Rx || nd.radio.rxPacket != -1) {
+            continue;
+        }
+        if (r.FREQUENCY != p.frequency || r.MODE != p.mode || nd.radio.listenStart > p.start) {
+            continue;
+        }
+        if (((r.PCNF1 >> RADIO_PCNF1_BALEN_Pos) & 7) != p.balen) {
+            continue;
+        }
+        int pipe = -1;
+        for (uint8_t i = 0; i < 8 && pipe < 0; i++) {
+            uint8_t prefix;
+            uint32_t base;
+            logicalAddress(r, i, &prefix, &base);
+            if ((r.RXADDRESSES & (1 << i)) && prefix == p.prefix && base == p.base) {
+                pipe = i;
+            }
+        }
+        if (pipe < 0) {
+            continue;
+        }
+        if (linkLoss[p.src][m] > 0 && (nextRandom(nd) % 10000) < linkLoss[p.src][m] * 100) {
+            stats.linkLosses++;
+            continue;
+        }
+
+        nd.radio.rxPacket = id;
+        r.RXMATCH = pipe;
+        TRACE(t, m, "RX ADDRESS packet %d from %d on pipe %d", id, p.src, pipe);
+        setEvent(nd, &r.EVENTS_ADDRESS, t);
+        if (r.SHORTS & RADIO_SHORTS_ADDRESS_RSSISTART_Msk) {
+            radioRssiStart(m, t);
+        }
+        uint32_t gen = nd.radio.gen;
+        schedule(p.end, [m, id, gen](uint64_t t) {
+            if (nodes[m].radio.gen == gen && nodes[m].radio.rxPacket == id) {
+                radioRxEnd(m, id, t);
+            }
+        });
+    }
+}
+
+void radioStart(int n, uint64_t t)
+{
+    Node& nd = nodes[n];
+    NRF_RADIO_Type& r = nd.p.radio;
+
+    if (r.STATE == RADIO_STATE_STATE_RxIdle) {
+        r.STATE = RADIO_STATE_STATE_Rx;
+        nd.radio.rxPacket = -1;
+        nd.radio.listenStart = t;
+        nd.radio.rxPtr = r.PACKETPTR;
+        TRACE(t, n, "RX START ch %u", r.FREQUENCY);
+        return;
+    }
+    if (r.STATE != RADIO_STATE_STATE_TxIdle) {
+        return;
+    }
+
+    // PACKETPTR is latched here, the whole frame is read from RAM straight away
+    const uint8_t* ram = dmaPtr(r.PACKETPTR);
+    uint32_t header, length;
+    frameLayout(r, ram, &header, &length);
+    uint32_t maxLength = (r.PCNF1 >> RADIO_PCNF1_MAXLEN_Pos) & 0xFF;
+    length = min(length, maxLength);
+
+    int id = nextPacketId++;
+    Packet& p = air[id];
+    p.src = n;
+    p.frequency = r.FREQUENCY;
+    p.mode = r.MODE;
+    p.balen = (r.PCNF1 >> RADIO_PCNF1_BALEN_Pos) & 7;
+    logicalAddress(r, r.TXADDRESS & 7, &p.prefix, &p.base);
+    p.frame.assign(ram, ram + header + length);
+    p.aborted = false;
+    p.crc = crc16(r, p.frame);
+
+    uint64_t bt = byteTime(r.MODE);
+    uint64_t preamble = (r.MODE & 0xF) == RADIO_MODE_MODE_Nrf_2Mbit ? 2 : 1;
+    uint32_t headerBits = ((r.PCNF0 >> RADIO_PCNF0_S0LEN_Pos) & 1) * 8 + ((r.PCNF0 >> RADIO_PCNF0_LFLEN_Pos) & 0xF)
+                          + ((r.PCNF0 >> RADIO_PCNF0_S1LEN_Pos) & 0xF);
+    p.start = t;
+    p.addrEnd = t + (preamble + p.balen + 1) * bt;
+    p.end = p.addrEnd + (headerBits * bt) / 8 + (length + (r.CRCCNF & 3)) * bt;
+
+    r.STATE = RADIO_STATE_STATE_Tx;
+    nd.radio.txPacket = id;
+    TRACE(t, n, "TX START packet %d, ch %u pipe %u, %u bytes, ends %.3f", id, p.frequency, r.TXADDRESS, (uint32_t)p.frame.size(),
+          p.end / 1000.0);
+    stats.packetsSent++;
+
+    uint32_t gen = nd.radio.gen;
+    schedule(p.addrEnd, [n, id, gen](uint64_t t) {
+        if (nodes[n].radio.gen == gen) {
+            setEvent(nodes[n], &nodes[n].p.radio.EVENTS_ADDRESS, t);
+        }
+        airAddress(id, t);
+    });
+    schedule(p.end, [n, id, gen](uint64_t t) {
+        Node& nd = nodes[n];
+        NRF_RADIO_Type& r = nd.p.radio;
+        if (nd.radio.gen != gen) {
+            return;
+        }
+        r.STATE = RADIO_STATE_STATE_TxIdle;
+        nd.radio.txPacket = -1;
+        TRACE(t, n, "TX END packet %d", id);
+        setEvent(nd, &r.EVENTS_PAYLOAD, t);
+        setEvent(nd, &r.EVENTS_END, t);
+        setEvent(nd, &r.EVENTS_PHYEND, t);
+        if (r.SHORTS & RADIO_SHORTS_END_DISABLE_Msk) {
+            radioDisable(n, t);
+        }
+        else if (r.SHORTS & RADIO_SHORTS_END_START_Msk) {
+            radioStart(n, t);
+        }
+    });
+}
+
+// Cut short a transmission, receivers see a CRC error
+void radioAbort(int n, uint64_t t)
+{
+    Node& nd = nodes[n];
+    if (nd.radio.txPacket >= 0) {
+        Packet& p = air[nd.radio.txPacket];
+        p.aborted = true;
+        p.end = min(p.end, t);
+        nd.radio.txPacket = -1;
+    }
+    nd.radio.rxPacket = -1;
+    nd.radio.gen++;
+}
+
+// Clearing RADIO POWER aborts any packet & puts every register back to its reset value
+void radioPowerOff(int n, uint64_t t)
+{
+    Node& nd = nodes[n];
+    NRF_RADIO_Type& r = nd.p.radio;
+    radioAbort(n, t);
+    TRACE(t, n, "POWER off");
+    uint32_t gen = nd.radio.gen;
+    memset(&r, 0, sizeof(r));
+    NRF_SIM_SETCLR_INIT(r.INTEN, r.INTEN)
+    nd.radio = RadioModel { gen, -1, -1, 0, 0 };
+}
+
+void radioDisable(int n, uint64_t t)
+{
+    Node& nd = nodes[n];
+    NRF_RADIO_Type& r = nd.p.radio;
+    radioAbort(n, t);
+    uint64_t delay = 0;
+    if (r.STATE >= RADIO_STATE_STATE_TxRu) {
+        r.STATE = RADIO_STATE_STATE_TxDisable;
+        delay = 6 * US;
+    }
+    else if (r.STATE != RADIO_STATE_STATE_Disabled) {
+        r.STATE = RADIO_STATE_STATE_RxDisable;
+        delay = 1 * US;
+    }
+    uint32_t gen = nd.radio.gen;
+    schedule(t + delay, [n, gen](uint64_t t) {
+        Node& nd = nodes[n];
+        NRF_RADIO_Type& r = nd.p.radio;
+        if (nd.radio.gen != gen) {
+            return;
+        }
+        r.STATE = RADIO_STATE_STATE_Disabled;
+        TRACE(t, n, "DISABLED shorts 0x%X", r.SHORTS);
+        setEvent(nd, &r.EVENTS_DISABLED, t);
+        if (r.SHORTS & RADIO_SHORTS_DISABLED_TXEN_Msk) {
+            radioTxEn(n, t);
+        }
+        else if (r.SHORTS & RADIO_SHORTS_DISABLED_RXEN_Msk) {
+            radioRxEn(n, t);
+        }
+    });
+}
+
+void radioStop(int n, uint64_t t)
+{
+    NRF_RADIO_Type& r = nodes[n].p.radio;
+    radioAbort(n, t);
+    if (r.STATE == RADIO_STATE_STATE_Tx) {
+        r.STATE = RADIO_STATE_STATE_TxIdle;
+    }
+    else if (r.STATE == RADIO_STATE_STATE_Rx) {
+        r.STATE = RADIO_STATE_STATE_RxIdle;
+    }
+}
+
+void radioRssiStart(int n, uint64_t t)
+{
+    schedule(t + 250, [n](uint64_t t) {
+        Node& nd = nodes[n];
+        nd.p.radio.RSSISAMPLE = -channelPower(n, t, t);
+        setEvent(nd, &nd.p.radio.EVENTS_RSSIEND, t);
+    });
+}
+
+void radioEdStart(int n, uint64_t t)
+{
+    uint64_t start = t;
+    uint64_t end = t + 128 * US * ((nodes[n].p.radio.EDCNT & 0x1FFFFF) + 1);
+    schedule(end, [n, start](uint64_t t) {
+        Node& nd = nodes[n];
+        // 1dB per ED step from -93dBm (ED_RSSIOFFS), sample_ed() scales this up to the IEEE 802.15.4 range
+        int level = channelPower(n, start, t) + 93;
+        nd.p.radio.EDSAMPLE = constrain(level, 0, 127);
+        setEvent(nd, &nd.p.radio.EVENTS_EDEND, t);
+    });
+}
+
+void radioCcaStart(int n, uint64_t t)
+{
+    uint64_t start = t;
+    schedule(t + 128 * US, [n, start](uint64_t t) {
+        Node& nd = nodes[n];
+        NRF_RADIO_Type& r = nd.p.radio;
+        uint32_t threshold = (r.CCACTRL >> 8) & 0xFF;
+        int thresholdDbm = threshold ? (int)threshold - 93 : -80;
+        bool busy = channelPower(n, start, t) > thresholdDbm;
+        setEvent(nd, busy ? &r.EVENTS_CCABUSY : &r.EVENTS_CCAIDLE, t);
+        if (busy && (r.SHORTS & RADIO_SHORTS_CCABUSY_DISABLE_Msk)) {
+            radioDisable(n, t);
+        }
+        if (!busy && (r.SHORTS & RADIO_SHORTS_CCAIDLE_STOP_Msk)) {
+            radioStop(n, t);
+        }
+        if (!busy && (r.SHORTS & RADIO_SHORTS_CCAIDLE_TXEN_Msk)) {
+            // The 802.15.4 mode RX to TX turnaround
+            nd.radio.gen++;
+            r.STATE = RADIO_STATE_STATE_Disabled;
+            radioTxEn(n, t);
+        }
+    });
+}
+
+/**************************************************************************************************************/
+// CCM, the real peripheral is AES-CCM. This model uses a keyed 64 bit mixing function instead, so it only
+// interoperates with itself, but keeps the same buffer formats, lengths & MIC checking.
+
+uint64_t mix64(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+void ccmCrypt(int n, uint64_t t)
+{
+    Node& nd = nodes[n];
+    NRF_CCM_Type& ccm = nd.p.ccm;
+    const uint8_t* cnf = dmaPtr(ccm.CNFPTR);
+    const uint8_t* in = dmaPtr(ccm.INPTR);
+    uint8_t* out = dmaPtr(ccm.OUTPTR);
+    bool decrypt = ccm.MODE & 1;
+
+    // Key (16), the 39 bit packet counter & the direction/IV bytes
+    uint64_t state = 0x6A09E667F3BCC908ULL;
+    for (int i = 0; i < 16; i++) {
+        state = mix64(state ^ cnf[i]);
+    }
+    for (int i = 16; i < 21; i++) {
+        state = mix64(state ^ (i == 20 ? cnf[i] & 0x7F : cnf[i]));
+    }
+    for (int i = 24; i < 33; i++) {
+        state = mix64(state ^ cnf[i]);
+    }
+
+    uint8_t length = in[1];
+    bool error = false;
+    uint8_t plainLength = length;
+    if (decrypt) {
+        if (length < 4) {
+            error = true;
+            plainLength = 0;
+        }
+        else {
+            plainLength = length - 4;
+        }
+    }
+    if (plainLength > ccm.MAXPACKETSIZE) {
+        error = true;
+        plainLength = 0;
+    }
+
+    uint64_t tag = mix64(state ^ plainLength);
+    for (uint8_t i = 0; i < plainLength; i++) {
+        uint8_t key = mix64(state + 1 + i / 8) >> (8 * (i % 8));
+        uint8_t plain = decrypt ? in[3 + i] ^ key : in[3 + i];
+        out[3 + i] = in[3 + i] ^ key;
+        tag = mix64(tag ^ plain);
+    }
+    out[0] = in[0];
+    out[2] = 0;
+    if (decrypt) {
+        out[1] = plainLength;
+        bool micOk = !error && memcmp(&in[3 + plainLength], &tag, 4) == 0;
+        ccm.MICSTATUS = micOk ? CCM_MICSTATUS_MICSTATUS_CheckPassed : CCM_MICSTATUS_MICSTATUS_CheckFailed;
+    }
+    else {
+        out[1] = plainLength + 4;
+        memcpy(&out[3 + plainLength], &tag, 4);
+    }
+
+    schedule(t + 2 * US + plainLength * 40, [n, error](uint64_t t) {
+        Node& nd = nodes[n];
+        setEvent(nd, error ? &nd.p.ccm.EVENTS_ERROR : &nd.p.ccm.EVENTS_ENDCRYPT, t);
+    });
+}
+
+void ccmKsgen(int n, uint64_t t)
+{
+    if (nodes[n].p.ccm.ENABLE != 2) {
+        return;
+    }
+    schedule(t + 2 * US, [n](uint64_t t) {
+        Node& nd = nodes[n];
+        setEvent(nd, &nd.p.ccm.EVENTS_ENDKSGEN, t);
+        if (nd.p.ccm.SHORTS & CCM_SHORTS_ENDKSGEN_CRYPT_Msk) {
+            ccmCrypt(n, t);
+        }
+    });
+}
+
+/**************************************************************************************************************/
+// RNG
+
+void rngNext(int n, uint64_t t)
+{
+    Node& nd = nodes[n];
+    uint32_t gen = nd.rngGen;
+    // Bias correction makes the RNG about 4x slower
+    uint64_t delay = (nd.p.rng.CONFIG & 1) ? 120 * US : 30 * US;
+    schedule(t + delay, [n, gen](uint64_t t) {
+        Node& nd = nodes[n];
+        if (nd.rngGen != gen || !nd.rngRunning) {
+            return;
+        }
+        nd.p.rng.VALUE = nextRandom(nd) & 0xFF;
+        setEvent(nd, &nd.p.rng.EVENTS_VALRDY, t);
+        if (nd.p.rng.SHORTS & RNG_SHORTS_VALRDY_STOP_Msk) {
+            nd.rngRunning = false;
+        }
+        else {
+            rngNext(n, t);
+        }
+    });
+}
+
+void rngStart(int n, uint64_t t)
+{
+    Node& nd = nodes[n];
+    if (nd.rngRunning) {
+        return;
+    }
+    nd.rngRunning = true;
+    nd.rngGen++;
+    rngNext(n, t);
+}
+
+void rngStop(int n)
+{
+    nodes[n].rngRunning = false;
+    nodes[n].rngGen++;
+}
+
+/**************************************************************************************************************/
+// TIMER
+
+uint32_t timerCount(Node& nd, int i, uint64_t t)
+{
+    TimerModel& tm = nd.timer[i];
+    if (!tm.running) {
+        return tm.base;
+    }
+    uint64_t tickX16 = 1000ULL << (nd.p.timer[i].PRESCALER & 0xF); // Tick length in ns * 16
+    return tm.base + (uint32_t)(((t - tm.startTime) * 16) / tickX16);
+}
+
+void timerStop(int n, int i, uint64_t t);
+void timerClear(int n, int i, uint64_t t);
+
+void timerSchedule(int n, int i, uint64_t t)
+{
+    Node& nd = nodes[n];
+    TimerModel& tm = nd.timer[i];
+    uint32_t gen = ++tm.gen;
+    if (!tm.running) {
+        return;
+    }
+    uint64_t tickX16 = 1000ULL << (nd.p.timer[i].PRESCALER & 0xF);
+    uint32_t count = timerCount(nd, i, t);
+    for (int c = 0; c < 6; c++) {
+        uint32_t cc = nd.p.timer[i].CC[c];
+        if (cc <= count) {
+            continue;
+        }
+        uint64_t at = tm.startTime + ((uint64_t)(cc - tm.base) * tickX16 + 15) / 16;
+        schedule(at, [n, i, c, gen](uint64_t t) {
+            Node& nd = nodes[n];
+            if (nd.timer[i].gen != gen) {
+                return;
+            }
+            setEvent(nd, &nd.p.timer[i].EVENTS_COMPARE[c], t);
+            if (nd.p.timer[i].SHORTS & (1UL << (8 + c))) {
+                timerStop(n, i, t);
+            }
+            if (nd.p.timer[i].SHORTS & (1UL << c)) {
+                timerClear(n, i, t);
+            }
+        });
+    }
+}
+
+void timerStart(int n, int i, uint64_t t)
+{
+    TimerModel& tm = nodes[n].timer[i];
+    if (tm.running) {
+        return;
+    }
+    tm.running = true;
+    tm.startTime = t;
+    timerSchedule(n, i, t);
+}
+
+void timerStop(int n, int i, uint64_t t)
+{
+    Node& nd = nodes[n];
+    nd.timer[i].base = timerCount(nd, i, t);
+    nd.timer[i].running = false;
+    nd.timer[i].gen++;
+}
+
+void timerClear(int n, int i, uint64_t t)
+{
+    TimerModel& tm = nodes[n].timer[i];
+    tm.base = 0;
+    tm.startTime = t;
+    timerSchedule(n, i, t);
+}
+
+/**************************************************************************************************************/
+// RTC, 24 bit counter on the 32.768kHz LFCLK. Compare events are only set when enabled in EVTEN or INTEN
+
+uint64_t rtcTickTime(Node& nd, int i, uint64_t ticks)
+{
+    return (ticks * ((nd.p.rtc[i].PRESCALER & 0xFFF) + 1) * 1000000000ULL + 32767) / 32768;
+}
+
+uint32_t rtcCount(Node& nd, int i, uint64_t t)
+{
+    TimerModel& rm = nd.rtc[i];
+    if (!rm.running) {
+        return rm.base;
+    }
+    uint64_t ticks = ((t - rm.startTime) * 32768) / (((nd.p.rtc[i].PRESCALER & 0xFFF) + 1) * 1000000000ULL);
+    return (rm.base + (uint32_t)ticks) & 0xFFFFFF;
+}
+
+void rtcClear(int n, int i, uint64_t t);
+
+void rtcSchedule(int n, int i, uint64_t t)
+{
+    Node& nd = nodes[n];
+    TimerModel& rm = nd.rtc[i];
+    uint32_t gen = ++rm.gen;
+    if (!rm.running) {
+        return;
+    }
+    uint32_t count = rtcCount(nd, i, t);
+    // Ticks since the model's start time, so the compare times are exact
+    uint64_t elapsed = (count - rm.base) & 0xFFFFFF;
+    for (int c = 0; c < 4; c++) {
+        uint32_t ahead = (nd.p.rtc[i].CC[c] - count) & 0xFFFFFF;
+        if (!ahead) {
+            ahead = 0x1000000;
+        }
+        schedule(rm.startTime + rtcTickTime(nd, i, elapsed + ahead), [n, i, c, gen](uint64_t t) {
+            Node& nd = nodes[n];
+            if (nd.rtc[i].gen != gen) {
+                return;
+            }
+            uint32_t mask = 1UL << (16 + c);
+            if ((nd.p.rtc[i].EVTEN | nd.p.rtc[i].INTEN) & mask) {
+                setEvent(nd, &nd.p.rtc[i].EVENTS_COMPARE[c], t);
+            }
+            // The event may have cleared or stopped the counter through PPI, otherwise wait for the next wrap
+            if (nd.rtc[i].gen == gen) {
+                rtcSchedule(n, i, t);
+            }
+        });
+    }
+}
+
+void rtcStart(int n, int i, uint64_t t)
+{
+    TimerModel& rm = nodes[n].rtc[i];
+    if (rm.running) {
+        return;
+    }
+    rm.running = true;
+    rm.startTime = t;
+    rtcSchedule(n, i, t);
+}
+
+void rtcStop(int n, int i, uint64_t t)
+{
+    Node& nd = nodes[n];
+    nd.rtc[i].base = rtcCount(nd, i, t);
+    nd.rtc[i].running = false;
+    nd.rtc[i].gen++;
+}
+
+void rtcClear(int n, int i, uint64_t t)
+{
+    TimerModel& rm = nodes[n].rtc[i];
+    rm.base = 0;
+    rm.startTime = t;
+    rtcSchedule(n, i, t);
+}
+
+/**************************************************************************************************************/
+
+void triggerTask(const void* task, uint64_t t)
+{
+    const char* address = (const char*)task;
+    const char* first = (const char*)&nodes[0];
+    if (address < first || address >= (const char*)&nodes[NRF_SIM_MAX_NODES]) {
+        fprintf(stderr, "nrf_sim: write to unknown task %p\n", task);
+        return;
+    }
+    int n = (address - first) / sizeof(Node);
+    Node& nd = nodes[n];
+    NRF_RADIO_Type& r = nd.p.radio;
+
+    if (task == &r.TASKS_TXEN) radioTxEn(n, t);
+    else if (task == &r.TASKS_RXEN) radioRxEn(n, t);
+    else if (task == &r.TASKS_START) radioStart(n, t);
+    else if (task == &r.TASKS_STOP) radioStop(n, t);
+    else if (task == &r.TASKS_DISABLE) radioDisable(n, t);
+    else if (task == &r.TASKS_RSSISTART) radioRssiStart(n, t);
+    else if (task == &r.TASKS_EDSTART) radioEdStart(n, t);
+    else if (task == &r.TASKS_CCASTART) radioCcaStart(n, t);
+    else if (task == &nd.p.ccm.TASKS_KSGEN) ccmKsgen(n, t);
+    else if (task == &nd.p.ccm.TASKS_CRYPT) ccmCrypt(n, t);
+    else if (task == &nd.p.rng.TASKS_START) rngStart(n, t);
+    else if (task == &nd.p.rng.TASKS_STOP) rngStop(n);
+    else if (task == &nd.p.clock.TASKS_HFCLKSTART) {
+        schedule(t + 50 * US, [n](uint64_t t) { setEvent(nodes[n], &nodes[n].p.clock.EVENTS_HFCLKSTARTED, t); });
+    }
+    else if (task == &nd.p.clock.TASKS_LFCLKSTART) {
+        schedule(t + 100 * US, [n](uint64_t t) { setEvent(nodes[n], &nodes[n].p.clock.EVENTS_LFCLKSTARTED, t); });
+    }
+    else {
+        for (int i = 0; i < 3; i++) {
+            NRF_TIMER_Type& timer = nd.p.timer[i];
+            if (task == &timer.TASKS_START) timerStart(n, i, t);
+            else if (task == &timer.TASKS_STOP || task == &timer.TASKS_SHUTDOWN) timerStop(n, i, t);
+            else if (task == &timer.TASKS_CLEAR) timerClear(n, i, t);
+            for (int c = 0; c < 6; c++) {
+                if (task == &timer.TASKS_CAPTURE[c]) {
+                    timer.CC[c] = timerCount(nd, i, t);
+                }
+            }
+        }
+        for (int i = 0; i < 3; i++) {
+            NRF_RTC_Type& rtc = nd.p.rtc[i];
+            if (task == &rtc.TASKS_START) rtcStart(n, i, t);
+            else if (task == &rtc.TASKS_STOP) rtcStop(n, i, t);
+            else if (task == &rtc.TASKS_CLEAR) rtcClear(n, i, t);
+        }
+        for (int g = 0; g < 6; g++) {
+            if (task == &nd.p.ppi.TASKS_CHG[g].EN) nd.p.ppi.CHEN |= nd.p.ppi.CHG[g];
+            else if (task == &nd.p.ppi.TASKS_CHG[g].DIS) nd.p.ppi.CHEN &= ~nd.p.ppi.CHG[g];
+        }
+    }
+}
+
+/**************************************************************************************************************/
+// Interrupts are delivered to a node whenever it passes through the scheduler
+
+bool irqPending(Node& nd, int irq)
+{
+    if (!(nd.nvicEnabled & (1UL << irq))) {
+        return false;
+    }
+    switch (irq) {
+        case RADIO_IRQn:
+            for (int bit = 0; bit < 28; bit++) {
+                if ((nd.p.radio.INTEN & (1UL << bit)) && (&nd.p.radio.EVENTS_READY)[bit]) {
+                    return true;
+                }
+            }
+            return false;
+        case RNG_IRQn: return (nd.p.rng.INTEN & 1) && nd.p.rng.EVENTS_VALRDY;
+        case CCM_AAR_IRQn:
+            return (nd.p.ccm.INTEN & 1 && nd.p.ccm.EVENTS_ENDKSGEN) || (nd.p.ccm.INTEN & 2 && nd.p.ccm.EVENTS_ENDCRYPT)
+                   || (nd.p.ccm.INTEN & 4 && nd.p.ccm.EVENTS_ERROR);
+        case TIMER0_IRQn:
+        case TIMER1_IRQn:
+        case TIMER2_IRQn:
+            for (int c = 0; c < 6; c++) {
+                NRF_TIMER_Type& timer = nd.p.timer[irq - TIMER0_IRQn];
+                if ((timer.INTEN & (1UL << (16 + c))) && timer.EVENTS_COMPARE[c]) {
+                    return true;
+                }
+            }
+            return false;
+    }
+    return false;
+}
+
+void dispatchIrqs(int n)
+{
+    Node& nd = nodes[n];
+    if (nd.inIsr || !nd.nvicEnabled) {
+        return;
+    }
+    static const struct
+    {
+        int irq;
+        void (*handler)(void);
+    } vectors[] = {
+        { RADIO_IRQn, RADIO_IRQHandler },
+        { TIMER0_IRQn, TIMER0_IRQHandler },
+        { TIMER1_IRQn, TIMER1_IRQHandler },
+        { TIMER2_IRQn, TIMER2_IRQHandler },
+        { RNG_IRQn, RNG_IRQHandler },
+        { CCM_AAR_IRQn, CCM_AAR_IRQHandler },
+    };
+    nd.inIsr = true;
+    // A handler that doesn't clear its event would be called forever, so give up after a few rounds
+    for (int round = 0; round < 8; round++) {
+        bool called = false;
+        for (auto& v : vectors) {
+            if (v.handler && irqPending(nd, v.irq)) {
+                v.handler();
+                called = true;
+            }
+        }
+        if (!called) {
+            break;
+        }
+    }
+    nd.inIsr = false;
+}
+
+/**************************************************************************************************************/
+// Scheduler, only the node with the lowest virtual time (give or take SYNC_QUANTUM) runs
+
+int lowestNode()
+{
+    int next = -1;
+    for (int i = 0; i < nodeCount; i++) {
+        if (!nodes[i].done && (next < 0 || nodes[i].time < nodes[next].time)) {
+            next = i;
+        }
+    }
+    return next;
+}
+
+// Called with schedMutex held by the running node, returns once it may continue
+void handOver(int n, std::unique_lock<std::mutex>& lock)
+{
+    int next = lowestNode();
+    if (next < 0 || nodes[next].time >= endTime) {
+        stopping = true;
+        schedCv.notify_all();
+        throw StopRun();
+    }
+    if (next != n && nodes[n].time > nodes[next].time + SYNC_QUANTUM) {
+        current = next;
+        schedCv.notify_all();
+        schedCv.wait(lock, [n] { return current == n || stopping; });
+        if (stopping) {
+            throw StopRun();
+        }
+    }
+    processEvents(nodes[n].time);
+}
+
+void schedulePoint(uint64_t cost)
+{
+    int n = self;
+    if (n < 0) {
+        return;
+    }
+    nodes[n].time += cost;
+    {
+        std::unique_lock<std::mutex> lock(schedMutex);
+        handOver(n, lock);
+    }
+    dispatchIrqs(n);
+}
+
+void nodeThread(int n)
+{
+    self = n;
+    Node& nd = nodes[n];
+    try {
+        {
+            std::unique_lock<std::mutex> lock(schedMutex);
+            schedCv.wait(lock, [n] { return current == n || stopping; });
+            if (stopping) {
+                throw StopRun();
+            }
+            processEvents(nd.time);
+        }
+        nd.setup();
+        for (;;) {
+            nd.loop();
+            schedulePoint(callCost);
+        }
+    }
+    catch (StopRun&) {
+    }
+    std::unique_lock<std::mutex> lock(schedMutex);
+    nd.done = true;
+    if (!stopping) {
+        current = lowestNode();
+    }
+    schedCv.notify_all();
+}
+
+void initNode(Node& nd, int n)
+{
+    memset(&nd.p, 0, sizeof(nd.p));
+    NRF_SIM_SETCLR_INIT(nd.p.radio.INTEN, nd.p.radio.INTEN)
+    NRF_SIM_SETCLR_INIT(nd.p.ccm.INTEN, nd.p.ccm.INTEN)
+    NRF_SIM_SETCLR_INIT(nd.p.rng.INTEN, nd.p.rng.INTEN)
+    for (int i = 0; i < 3; i++) {
+        NRF_SIM_SETCLR_INIT(nd.p.timer[i].INTEN, nd.p.timer[i].INTEN)
+    }
+    for (int i = 0; i < 3; i++) {
+        NRF_SIM_SETCLR_INIT(nd.p.rtc[i].INTEN, nd.p.rtc[i].INTEN)
+        NRF_SIM_SETCLR_INIT(nd.p.rtc[i].EVTEN, nd.p.rtc[i].EVTEN)
+    }
+    NRF_SIM_SETCLR_INIT(nd.p.ppi.CHEN, nd.p.ppi.CHEN)
+    // Reset values that differ from zero
+    nd.p.radio.CRCPOLY = 0;
+    nd.p.radio.TIFS = 0;
+    nd.p.radio.POWER.value = 1;
+    nd.p.rng.VALUE = 0;
+    nd.radio = RadioModel { 0, -1, -1, 0, 0 };
+    for (int i = 0; i < 3; i++) {
+        nd.timer[i] = TimerModel { false, 0, 0, 0 };
+        nd.rtc[i] = TimerModel { false, 0, 0, 0 };
+    }
+    nd.rngRunning = false;
+    nd.rngGen = 0;
+    nd.active = true;
+    nd.done = false;
+    nd.time = 0;
+    nd.nvicEnabled = 0;
+    nd.inIsr = false;
+    nd.lineStart = true;
+    nd.random = seed * 0x9E3779B97F4A7C15ULL + n;
+}
+
+} // namespace
+
+/**************************************************************************************************************/
+
+void nrf_sim_task_t::operator=(uint32_t value)
+{
+    if (value && self >= 0) {
+        triggerTask(this, nodes[self].time);
+    }
+}
+
+void nrf_sim_power_t::operator=(uint32_t on)
+{
+    if (!on && value && self >= 0) {
+        radioPowerOff(self, nodes[self].time);
+    }
+    value = on ? 1 : 0;
+}
+
+nrf_sim_rtc_counter_t::operator uint32_t() const
+{
+    const char* address = (const char*)this;
+    const char* first = (const char*)&nodes[0];
+    int n = (address - first) / sizeof(Node);
+    for (int i = 0; i < 3; i++) {
+        if (this == &nodes[n].p.rtc[i].COUNTER) {
+            return rtcCount(nodes[n], i, nodes[n].time);
+        }
+    }
+    return 0;
+}
+
+nrf_sim_peripherals_t* nrf_sim_peripherals()
+{
+    if (self < 0) {
+        fprintf(stderr, "nrf_sim: peripherals accessed outside of a node\n");
+        abort();
+    }
+    return &nodes[self].p;
+}
+
+void NVIC_EnableIRQ(IRQn_Type irq)
+{
+    if (self >= 0) {
+        nodes[self].nvicEnabled |= 1UL << irq;
+    }
+}
+
+void NVIC_DisableIRQ(IRQn_Type irq)
+{
+    if (self >= 0) {
+        nodes[self].nvicEnabled &= ~(1UL << irq);
+    }
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type) {}
+void NVIC_SetPriority(IRQn_Type, uint32_t) {}
+
+namespace nrf_sim {
+
+int addNode(void (*setup)(void), void (*loop)(void))
+{
+    if (nodeCount >= NRF_SIM_MAX_NODES || ran) {
+        return -1;
+    }
+    int n = nodeCount++;
+    initNode(nodes[n], n);
+    nodes[n].setup = setup;
+    nodes[n].loop = loop;
+    for (int i = 0; i < NRF_SIM_MAX_NODES; i++) {
+        linkRssi[n][i] = linkRssi[i][n] = -40;
+    }
+    return n;
+}
+
+void run(uint32_t durationMs)
+{
+    if (ran) {
+        return;
+    }
+    ran = true;
+    // EasyDMA pointers are 32 bit registers, so all buffers handed to the peripherals must be below 4GB
+    if ((uint64_t)(uintptr_t)&nodes[NRF_SIM_MAX_NODES] > 0xFFFFFFFFULL) {
+        fprintf(stderr, "nrf_sim: static data is above 4GB, build with -no-pie (or -m32)\n");
+        abort();
+    }
+    endTime = (uint64_t)durationMs * 1000 * US;
+    trace = getenv("NRF_SIM_TRACE") != NULL;
+    {
+        std::unique_lock<std::mutex> lock(schedMutex);
+        for (int i = 0; i < nodeCount; i++) {
+            nodes[i].thread = std::thread(nodeThread, i);
+        }
+        current = lowestNode();
+        schedCv.notify_all();
+    }
+    for (int i = 0; i < nodeCount; i++) {
+        nodes[i].thread.join();
+    }
+    simNow = endTime;
+    fflush(stdout);
+}
+
+void stop()
+{
+    if (self >= 0 && nodes[self].time < endTime) {
+        endTime = nodes[self].time;
+    }
+}
+
+uint64_t now()
+{
+    return (self >= 0 ? nodes[self].time : simNow) / US;
+}
+
+int currentNode()
+{
+    return self;
+}
+
+void setLinkRssi(int from, int to, int dBm)
+{
+    linkRssi[from][to] = dBm;
+}
+
+void setLinkLoss(int from, int to, float percent)
+{
+    linkLoss[from][to] = percent;
+}
+
+void setCallCost(uint32_t nanoseconds)
+{
+    callCost = nanoseconds;
+}
+
+void setSeed(uint32_t value)
+{
+    seed = value;
+}
+
+stats_t getStats()
+{
+    return stats;
+}
+
+} // namespace nrf_sim
+
+/**************************************************************************************************************/
+// Arduino API
+
+unsigned long millis(void)
+{
+    schedulePoint(callCost);
+    return nrf_sim::now() / 1000;
+}
+
+unsigned long micros(void)
+{
+    schedulePoint(callCost);
+    return nrf_sim::now();
+}
+
+void delay(unsigned long ms)
+{
+    schedulePoint((uint64_t)ms * 1000 * US);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    schedulePoint((uint64_t)us * US);
+}
+
+void yield(void)
+{
+    schedulePoint(callCost);
+}
+
+long random(long howBig)
+{
+    if (howBig <= 0 || self < 0) {
+        return 0;
+    }
+    return nextRandom(nodes[self]) % howBig;
+}
+
+long random(long howSmall, long howBig)
+{
+    if (howSmall >= howBig) {
+        return howSmall;
+    }
+    return howSmall + random(howBig - howSmall);
+}
+
+void randomSeed(unsigned long value)
+{
+    if (self >= 0) {
+        nodes[self].random = value;
+    }
+}
+
+SimSerial Serial;
+
+size_t SimSerial::write(uint8_t c)
+{
+    bool* lineStart = self >= 0 ? &nodes[self].lineStart : NULL;
+    if (lineStart && *lineStart) {
+        fprintf(stdout, "[%d] ", self);
+    }
+    fputc(c, stdout);
+    if (lineStart) {
+        *lineStart = c == '\n';
+    }
+    return 1;
+}
+
+size_t SimSerial::print(const char* str)
+{
+    size_t n = 0;
+    while (*str) {
+        n += write(*str++);
+    }
+    return n;
+}
+
+size_t SimSerial::print(char c)
+{
+    return write(c);
+}
+
+size_t SimSerial::print(double n, int digits)
+{
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", digits, n);
+    return print(buffer);
+}
+
+size_t SimSerial::printf(const char* format, ...)
+{
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    return print(buffer);
+}
+
+size_t SimSerial::printSigned(long long n, int base)
+{
+    if (n < 0 && base == DEC) {
+        return printNumber(-(unsigned long long)n, base, true);
+    }
+    return printNumber((unsigned long long)n, base, false);
+}
+
+size_t SimSerial::printNumber(unsigned long long n, int base, bool negative)
+{
+    char buffer[66];
+    char* str = &buffer[sizeof(buffer) - 1];
+    *str = '\0';
+    if (base < 2) {
+        base = 10;
+    }
+    do {
+        int digit = n % base;
+        *--str = digit < 10 ? '0' + digit : 'A' + digit - 10;
+        n /= base;
+    } while (n);
+    if (negative) {
+        *--str = '-';
+    }
+    return print(str);
+}
@@ -0,0 +1,367 @@
+/**
+ * @file nrf_sim.h
+ *
+ * Host side model of the nRF52 peripherals used by nrf_to_nrf (RADIO, CCM, RNG, CLOCK, POWER, TIMER, RTC & PPI)
+ *
+ * Each simulated node runs its own setup()/loop() on a separate thread, but only one node runs at a time and
+ * all of them share a virtual clock, so runs are repeatable. See README.md in this directory.
+ */
+#ifndef __NRF_SIM_H__
+#define __NRF_SIM_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef NRF_SIM_MAX_NODES
+    #define NRF_SIM_MAX_NODES 8
+#endif
+
+/**
+ * A task register, writing a non-zero value triggers the task in the peripheral model
+ */
+struct nrf_sim_task_t
+{
+    void operator=(uint32_t value);
+    operator uint32_t() const { return 0; }
+};
+
+/**
+ * An INTENSET/INTENCLR or CHENSET/CHENCLR style register, writing sets or clears bits of another register
+ */
+struct nrf_sim_setclr_t
+{
+    volatile uint32_t* reg;
+    bool set;
+    void operator=(uint32_t value)
+    {
+        if (set) {
+            *reg |= value;
+        }
+        else {
+            *reg &= ~value;
+        }
+    }
+    operator uint32_t() const { return *reg; }
+};
+
+/**
+ * The RTC COUNTER register, reads the count at the node's current time
+ */
+struct nrf_sim_rtc_counter_t
+{
+    operator uint32_t() const;
+};
+
+/**
+ * The RADIO POWER register, switching the radio off resets all its registers as on the nRF52
+ */
+struct nrf_sim_power_t
+{
+    volatile uint32_t value;
+    void operator=(uint32_t on);
+    operator uint32_t() const { return value; }
+};
+
+#define NRF_SIM_SETCLR_INIT(name, target) \
+    name##SET.reg = &target;              \
+    name##SET.set = true;                 \
+    name##CLR.reg = &target;              \
+    name##CLR.set = false;
+
+/**************************************************************************************************************/
+// Register blocks, laid out with the same names (and event ordering) as the nRF52840 MDK
+
+typedef struct
+{
+    nrf_sim_task_t TASKS_TXEN, TASKS_RXEN, TASKS_START, TASKS_STOP, TASKS_DISABLE, TASKS_RSSISTART, TASKS_RSSISTOP,
+        TASKS_BCSTART, TASKS_BCSTOP, TASKS_EDSTART, TASKS_EDSTOP, TASKS_CCASTART, TASKS_CCASTOP;
+    // Events are kept in INTEN bit order, so (&EVENTS_READY)[n] is the event for INTEN bit n
+    volatile uint32_t EVENTS_READY, EVENTS_ADDRESS, EVENTS_PAYLOAD, EVENTS_END, EVENTS_DISABLED, EVENTS_DEVMATCH,
+        EVENTS_DEVMISS, EVENTS_RSSIEND, RESERVED0[2], EVENTS_BCMATCH, RESERVED1, EVENTS_CRCOK, EVENTS_CRCERROR,
+        EVENTS_FRAMESTART, EVENTS_EDEND, EVENTS_EDSTOPPED, EVENTS_CCAIDLE, EVENTS_CCABUSY, EVENTS_CCASTOPPED,
+        EVENTS_RATEBOOST, EVENTS_TXREADY, EVENTS_RXREADY, EVENTS_MHRMATCH, RESERVED2[3], EVENTS_PHYEND;
+    volatile uint32_t SHORTS, INTEN;
+    nrf_sim_setclr_t INTENSET, INTENCLR;
+    volatile uint32_t CRCSTATUS, RXMATCH, RXCRC, DAI, PDUSTAT, PACKETPTR, FREQUENCY, TXPOWER, MODE, PCNF0, PCNF1,
+        BASE0, BASE1, PREFIX0, PREFIX1, TXADDRESS, RXADDRESSES, CRCCNF, CRCPOLY, CRCINIT, TIFS, RSSISAMPLE, STATE,
+        DATAWHITEIV, BCC, DAB[8], DAP[8], DACNF, MHRMATCHCONF, MHRMATCHMAS, MODECNF0, SFD, EDCNT, EDSAMPLE, CCACTRL;
+    nrf_sim_power_t POWER;
+} NRF_RADIO_Type;
+
+typedef struct
+{
+    nrf_sim_task_t TASKS_KSGEN, TASKS_CRYPT, TASKS_STOP, TASKS_RATEOVERRIDE;
+    volatile uint32_t EVENTS_ENDKSGEN, EVENTS_ENDCRYPT, EVENTS_ERROR;
+    volatile uint32_t SHORTS, INTEN;
+    nrf_sim_setclr_t INTENSET, INTENCLR;
+    volatile uint32_t MICSTATUS, ENABLE, MODE, CNFPTR, INPTR, OUTPTR, SCRATCHPTR, MAXPACKETSIZE, RATEOVERRIDE;
+} NRF_CCM_Type;
+
+typedef struct
+{
+    nrf_sim_task_t TASKS_START, TASKS_STOP;
+    volatile uint32_t EVENTS_VALRDY;
+    volatile uint32_t SHORTS, INTEN;
+    nrf_sim_setclr_t INTENSET, INTENCLR;
+    volatile uint32_t CONFIG, VALUE;
+} NRF_RNG_Type;
+
+typedef struct
+{
+    nrf_sim_task_t TASKS_HFCLKSTART, TASKS_HFCLKSTOP, TASKS_LFCLKSTART, TASKS_LFCLKSTOP;
+    volatile uint32_t EVENTS_HFCLKSTARTED, EVENTS_LFCLKSTARTED;
+    volatile uint32_t LFCLKSRC;
+} NRF_CLOCK_Type;
+
+typedef struct
+{
+    nrf_sim_task_t TASKS_CONSTLAT, TASKS_LOWPWR;
+} NRF_POWER_Type;
+
+typedef struct
+{
+    nrf_sim_task_t TASKS_START, TASKS_STOP, TASKS_COUNT, TASKS_CLEAR, TASKS_SHUTDOWN, TASKS_CAPTURE[6];
+    volatile uint32_t EVENTS_COMPARE[6];
+    volatile uint32_t SHORTS, INTEN;
+    nrf_sim_setclr_t INTENSET, INTENCLR;
+    volatile uint32_t MODE, BITMODE, PRESCALER, CC[6];
+} NRF_TIMER_Type;
+
+typedef struct
+{
+    nrf_sim_task_t TASKS_START, TASKS_STOP, TASKS_CLEAR, TASKS_TRIGOVRFLW;
+    volatile uint32_t EVENTS_TICK, EVENTS_OVRFLW, EVENTS_COMPARE[4];
+    volatile uint32_t INTEN; // Not a register on the real RTC, holds the INTENSET/INTENCLR state
+    nrf_sim_setclr_t INTENSET, INTENCLR;
+    volatile uint32_t EVTEN;
+    nrf_sim_setclr_t EVTENSET, EVTENCLR;
+    nrf_sim_rtc_counter_t COUNTER;
+    volatile uint32_t PRESCALER, CC[4];
+} NRF_RTC_Type;
+
+typedef struct
+{
+    struct
+    {
+        nrf_sim_task_t EN, DIS;
+    } TASKS_CHG[6];
+    volatile uint32_t CHEN;
+    nrf_sim_setclr_t CHENSET, CHENCLR;
+    struct
+    {
+        volatile uint32_t EEP, TEP;
+    } CH[20];
+    volatile uint32_t CHG[6];
+    struct
+    {
+        volatile uint32_t TEP;
+    } FORK[32];
+} NRF_PPI_Type;
+
+typedef enum
+{
+    RADIO_IRQn = 1,
+    TIMER0_IRQn = 8,
+    TIMER1_IRQn = 9,
+    TIMER2_IRQn = 10,
+    RNG_IRQn = 13,
+    CCM_AAR_IRQn = 15,
+} IRQn_Type;
+
+/**
+ * The peripherals of one simulated nRF52
+ */
+typedef struct
+{
+    NRF_RADIO_Type radio;
+    NRF_CCM_Type ccm;
+    NRF_RNG_Type rng;
+    NRF_CLOCK_Type clock;
+    NRF_POWER_Type power;
+    NRF_TIMER_Type timer[3];
+    NRF_RTC_Type rtc[3];
+    NRF_PPI_Type ppi;
+} nrf_sim_peripherals_t;
+
+/**
+ * Peripherals of the node whose code is currently running
+ */
+nrf_sim_peripherals_t* nrf_sim_peripherals();
+
+#define NRF_RADIO  (&nrf_sim_peripherals()->radio)
+#define NRF_CCM    (&nrf_sim_peripherals()->ccm)
+#define NRF_RNG    (&nrf_sim_peripherals()->rng)
+#define NRF_CLOCK  (&nrf_sim_peripherals()->clock)
+#define NRF_POWER  (&nrf_sim_peripherals()->power)
+#define NRF_TIMER0 (&nrf_sim_peripherals()->timer[0])
+#define NRF_TIMER1 (&nrf_sim_peripherals()->timer[1])
+#define NRF_TIMER2 (&nrf_sim_peripherals()->timer[2])
+#define NRF_RTC0   (&nrf_sim_peripherals()->rtc[0])
+#define NRF_RTC1   (&nrf_sim_peripherals()->rtc[1])
+#define NRF_RTC2   (&nrf_sim_peripherals()->rtc[2])
+#define NRF_PPI    (&nrf_sim_peripherals()->ppi)
+
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_DisableIRQ(IRQn_Type irq);
+void NVIC_ClearPendingIRQ(IRQn_Type irq);
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority);
+
+/**************************************************************************************************************/
+// Register field definitions used by nrf_to_nrf
+
+#define RADIO_STATE_STATE_Disabled   (0UL)
+#define RADIO_STATE_STATE_RxRu       (1UL)
+#define RADIO_STATE_STATE_RxIdle     (2UL)
+#define RADIO_STATE_STATE_Rx         (3UL)
+#define RADIO_STATE_STATE_RxDisable  (4UL)
+#define RADIO_STATE_STATE_TxRu       (9UL)
+#define RADIO_STATE_STATE_TxIdle     (10UL)
+#define RADIO_STATE_STATE_Tx         (11UL)
+#define RADIO_STATE_STATE_TxDisable  (12UL)
+
+#define RADIO_SHORTS_READY_START_Msk       (1UL << 0)
+#define RADIO_SHORTS_END_DISABLE_Msk       (1UL << 1)
+#define RADIO_SHORTS_DISABLED_TXEN_Msk     (1UL << 2)
+#define RADIO_SHORTS_DISABLED_RXEN_Msk     (1UL << 3)
+#define RADIO_SHORTS_ADDRESS_RSSISTART_Msk (1UL << 4)
+#define RADIO_SHORTS_END_START_Msk         (1UL << 5)
+#define RADIO_SHORTS_DISABLED_RSSISTOP_Msk (1UL << 8)
+#define RADIO_SHORTS_RXREADY_CCASTART_Msk  (1UL << 11)
+#define RADIO_SHORTS_CCAIDLE_TXEN_Msk      (1UL << 12)
+#define RADIO_SHORTS_CCABUSY_DISABLE_Msk   (1UL << 13)
+#define RADIO_SHORTS_CCAIDLE_STOP_Msk      (1UL << 17)
+#define RADIO_SHORTS_TXREADY_START_Msk     (1UL << 18)
+#define RADIO_SHORTS_RXREADY_START_Msk     (1UL << 19)
+
+#define RADIO_INTENSET_READY_Msk    (1UL << 0)
+#define RADIO_INTENSET_ADDRESS_Msk  (1UL << 1)
+#define RADIO_INTENSET_END_Msk      (1UL << 3)
+#define RADIO_INTENSET_DISABLED_Msk (1UL << 4)
+#define RADIO_INTENSET_RSSIEND_Msk  (1UL << 7)
+#define RADIO_INTENSET_CRCOK_Msk    (1UL << 12)
+#define RADIO_INTENSET_CRCERROR_Msk (1UL << 13)
+#define RADIO_INTENSET_EDEND_Msk    (1UL << 15)
+#define RADIO_INTENSET_CCABUSY_Msk  (1UL << 18)
+#define RADIO_INTENSET_TXREADY_Msk  (1UL << 21)
+#define RADIO_INTENSET_RXREADY_Msk  (1UL << 22)
+
+#define RADIO_MODE_MODE_Pos         (0UL)
+#define RADIO_MODE_MODE_Nrf_1Mbit   (0UL)
+#define RADIO_MODE_MODE_Nrf_2Mbit   (1UL)
+#define RADIO_MODE_MODE_Nrf_250Kbit (2UL)
+
+#define RADIO_PCNF0_LFLEN_Pos (0UL)
+#define RADIO_PCNF0_S0LEN_Pos (8UL)
+#define RADIO_PCNF0_S1LEN_Pos (16UL)
+
+#define RADIO_PCNF1_MAXLEN_Pos       (0UL)
+#define RADIO_PCNF1_STATLEN_Pos      (8UL)
+#define RADIO_PCNF1_BALEN_Pos        (16UL)
+#define RADIO_PCNF1_ENDIAN_Pos       (24UL)
+#define RADIO_PCNF1_ENDIAN_Big       (1UL)
+#define RADIO_PCNF1_WHITEEN_Pos      (25UL)
+#define RADIO_PCNF1_WHITEEN_Disabled (0UL)
+
+#define RADIO_CRCCNF_LEN_Disabled (0UL)
+#define RADIO_CRCCNF_LEN_One      (1UL)
+#define RADIO_CRCCNF_LEN_Two      (2UL)
+#define RADIO_CRCCNF_LEN_Three    (3UL)
+
+#define RADIO_FREQUENCY_MAP_Pos  (8UL)
+#define RADIO_TXPOWER_TXPOWER_Pos (0UL)
+
+#define RADIO_CCACTRL_CCAMODE_Pos    (0UL)
+#define RADIO_CCACTRL_CCAMODE_EdMode (0UL)
+#define RADIO_CCACTRL_CCAEDTHRES_Pos (8UL)
+
+#define CCM_MICSTATUS_MICSTATUS_Pos         (0UL)
+#define CCM_MICSTATUS_MICSTATUS_CheckFailed (0UL)
+#define CCM_MICSTATUS_MICSTATUS_CheckPassed (1UL)
+#define CCM_SHORTS_ENDKSGEN_CRYPT_Msk       (1UL << 0)
+
+#define RNG_INTENSET_VALRDY_Msk   (1UL << 0)
+#define RNG_SHORTS_VALRDY_STOP_Msk (1UL << 0)
+
+#define TIMER_MODE_MODE_Timer           (0UL)
+#define TIMER_BITMODE_BITMODE_32Bit     (3UL)
+#define TIMER_SHORTS_COMPARE0_CLEAR_Msk (1UL << 0)
+#define TIMER_SHORTS_COMPARE0_STOP_Msk  (1UL << 8)
+
+#define RTC_EVTEN_COMPARE0_Msk (1UL << 16)
+#define RTC_EVTEN_COMPARE1_Msk (1UL << 17)
+#define RTC_EVTEN_COMPARE2_Msk (1UL << 18)
+#define RTC_EVTEN_COMPARE3_Msk (1UL << 19)
+
+/**************************************************************************************************************/
+// Simulation control, called from the host program's main()
+
+namespace nrf_sim {
+
+/**
+ * Add a node running @p setup once and then @p loop forever, like an Arduino sketch
+ * @return The node number, used by the link functions below
+ */
+int addNode(void (*setup)(void), void (*loop)(void));
+
+/**
+ * Run all nodes until the virtual clock reaches @p durationMs, can only be called once
+ */
+void run(uint32_t durationMs);
+
+/**
+ * End run() at the current virtual time, called from a node once it has finished its work
+ */
+void stop();
+
+/**
+ * The virtual time in microseconds of the node that is currently running (or the end of the last run())
+ */
+uint64_t now();
+
+/**
+ * The node whose code is currently running, or -1 from main()
+ */
+int currentNode();
+
+/**
+ * Set the received signal strength from node @p from at node @p to, defaults to -40dBm for every link
+ */
+void setLinkRssi(int from, int to, int dBm);
+
+/**
+ * Drop packets sent from node @p from to node @p to with a probability of @p percent (0 - 100)
+ */
+void setLinkLoss(int from, int to, float percent);
+
+/**
+ * Virtual CPU time charged for every call to millis()/micros()/yield(), defaults to 1000ns
+ *
+ * Code between these calls takes no virtual time, so this approximates the cost of polling loops
+ */
+void setCallCost(uint32_t nanoseconds);
+
+/**
+ * Seed the per-node random number generators (RNG peripheral & link loss), defaults to 1
+ */
+void setSeed(uint32_t seed);
+
+/**
+ * Airtime and collision counters for the whole simulation
+ */
+typedef struct
+{
+    uint32_t packetsSent;
+    uint32_t packetsReceived;
+    uint32_t crcErrors;
+    uint32_t collisions;
+    uint32_t linkLosses;
+} stats_t;
+
+/**
+ * Get the air channel counters
+ */
+stats_t getStats();
+
+} // namespace nrf_sim
+
+#endif // __NRF_SIM_H__
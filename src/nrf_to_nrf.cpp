@@ -35,6 +35,102 @@
 #endif
 
 #define DEFAULT_TIMEOUT 250
+#define ACK_SLOT_FREE   0xFF
+#define HOP_NOT_TUNED   0xFF
+#define RSSI_SETTLE_US  15 // RSSI settling time after the receiver is enabled
+#define CCA_US          128 // Energy detection time of one clear channel assessment
+
+// While receiving, the RSSI of every packet is sampled as its address comes in, see getPacketRSSI()
+#ifndef ARDUINO_NRF54L15
+    #define RX_RSSI_SHORTS RADIO_SHORTS_ADDRESS_RSSISTART_Msk
+#else
+    #define RX_RSSI_SHORTS 0
+#endif
+
+// Storage class of the instance pointers used by the interrupt handlers (the host simulator needs one per node)
+#ifndef NRF_ISR_INSTANCE
+    #define NRF_ISR_INSTANCE static
+#endif
+
+// Cycle counting for getCycleStats(), compiles to nothing unless NRF_CYCLE_STATS is defined
+// The TX_STAGE versions time the stages of the TX state machine, which span several calls to updateTx()
+#if defined NRF_CYCLE_STATS
+    #define NRF_STAGE_START(name)       uint32_t name = NRF_CYCLE_CLOCK()
+    #define NRF_STAGE_END(stage, start) addCycles(stage, NRF_CYCLE_CLOCK() - (start))
+    #define NRF_TX_STAGE_START()        txStageStart = NRF_CYCLE_CLOCK()
+    #define NRF_TX_STAGE_END(stage)     addCycles(stage, NRF_CYCLE_CLOCK() - txStageStart)
+#else
+    #define NRF_STAGE_START(name)
+    #define NRF_STAGE_END(stage, start)
+    #define NRF_TX_STAGE_START()
+    #define NRF_TX_STAGE_END(stage)
+#endif
+
+#if defined NRF_RADIO_IRQ_ENABLED
+    #ifndef ARDUINO_NRF54L15
+        #define RADIO_IRQ_NUMBER  RADIO_IRQn
+        #define RADIO_IRQ_HANDLER RADIO_IRQHandler
+        #define RADIO_INTENSET    INTENSET
+        #define RADIO_INTENCLR    INTENCLR
+        #define RADIO_IRQ_RX_MASK (RADIO_INTENSET_CRCOK_Msk | RADIO_INTENSET_CRCERROR_Msk)
+        // Moves the HW ACK turnaround on, see hwAckUpdate()
+        #define RADIO_IRQ_ACK_MASK (RADIO_INTENSET_READY_Msk | RADIO_INTENSET_RXREADY_Msk)
+        #ifdef NRF_HAS_ENERGY_DETECT
+            #define RADIO_IRQ_CCA_MASK RADIO_INTENSET_CCABUSY_Msk
+        #else
+            #define RADIO_IRQ_CCA_MASK 0
+        #endif
+        // Every event a TX stage can wait for, see NRF_TX_WAIT()
+        #define RADIO_IRQ_TX_MASK                                                                                  \
+            (RADIO_INTENSET_READY_Msk | RADIO_INTENSET_ADDRESS_Msk | RADIO_INTENSET_END_Msk |                      \
+             RADIO_INTENSET_DISABLED_Msk | RADIO_INTENSET_CRCOK_Msk | RADIO_INTENSET_CRCERROR_Msk | RADIO_IRQ_CCA_MASK)
+        #define RADIO_IRQ_READY    RADIO_INTENSET_READY_Msk
+        #define RADIO_IRQ_ADDRESS  RADIO_INTENSET_ADDRESS_Msk
+        #define RADIO_IRQ_END      RADIO_INTENSET_END_Msk
+        #define RADIO_IRQ_DISABLED RADIO_INTENSET_DISABLED_Msk
+    #else
+        #define RADIO_IRQ_NUMBER  RADIO_0_IRQn
+        #define RADIO_IRQ_HANDLER RADIO_0_IRQHandler
+        #define RADIO_INTENSET    INTENSET00
+        #define RADIO_INTENCLR    INTENCLR00
+        #define RADIO_IRQ_RX_MASK (RADIO_INTENSET00_CRCOK_Msk | RADIO_INTENSET00_CRCERROR_Msk)
+        #define RADIO_IRQ_TX_MASK                                                                                  \
+            (RADIO_INTENSET00_READY_Msk | RADIO_INTENSET00_ADDRESS_Msk | RADIO_INTENSET00_END_Msk |                \
+             RADIO_INTENSET00_DISABLED_Msk | RADIO_INTENSET00_CRCOK_Msk | RADIO_INTENSET00_CRCERROR_Msk)
+        #define RADIO_IRQ_READY    RADIO_INTENSET00_READY_Msk
+        #define RADIO_IRQ_ADDRESS  RADIO_INTENSET00_ADDRESS_Msk
+        #define RADIO_IRQ_END      RADIO_INTENSET00_END_Msk
+        #define RADIO_IRQ_DISABLED RADIO_INTENSET00_DISABLED_Msk
+    #endif
+    // Interrupts only on the events the current TX stage waits for, updateTx() is then run from the handler
+    #define NRF_TX_WAIT(events)                                                                                    \
+        do {                                                                                                       \
+            NRF_RADIO->RADIO_INTENCLR = RADIO_IRQ_TX_MASK & ~(events);                                            \
+            NRF_RADIO->RADIO_INTENSET = (events);                                                                  \
+        } while (0)
+
+NRF_ISR_INSTANCE nrf_to_nrf* radioInstance = NULL;
+
+extern "C" void RADIO_IRQ_HANDLER(void)
+{
+    if (radioInstance != NULL) {
+        radioInstance->handleRadioIRQ();
+    }
+}
+#else
+    #define NRF_TX_WAIT(events)
+#endif
+
+#if defined NRF_RNG_POOL
+NRF_ISR_INSTANCE nrf_to_nrf* rngInstance = NULL;
+
+extern "C" void RNG_IRQHandler(void)
+{
+    if (rngInstance != NULL) {
+        rngInstance->handleRngIRQ();
+    }
+}
+#endif
 
 /**********************************************************************************************************/
 
@@ -92,12 +188,69 @@ nrf_to_nrf::nrf_to_nrf()
     staticPayloadSize = 32;
     retries = 5;
     retryDuration = 5;
+    backoffPolicy = NRF_BACKOFF_FIXED;
+    backoffCap = 5;
+    backoffState = 0;
+    memset(backoffStats, 0, sizeof(backoffStats));
+    txBackoff = 0;
+    txBackedOff = false;
     ackPayloadsEnabled = false;
-    ackPipe = 0;
+    for (uint8_t i = 0; i < NRF_ACK_FIFO_SIZE; i++) {
+        ackSlots[i].pipe = ACK_SLOT_FREE;
+    }
+    ackCount = 0;
+    ackSentPipes = 0;
     inRxMode = false;
     arcCounter = 0;
-    ackTimeout = ACK_TIMEOUT_1MBPS;
-    payloadAvailable = false;
+    rxFifoHead = 0;
+    rxFifoTail = 0;
+    rxFifoCount = 0;
+    rxBusy = false;
+#if defined NRF_RADIO_IRQ_ENABLED
+    rxAckDeferred = false;
+#endif
+    rxFrame = radioData;
+    rxLastRSSI = 0;
+    ccaThreshold = 0;
+    clockPending = false;
+#if defined NRF_DUTY_CYCLE
+    dutyWindowTicks = 0;
+    dutyShorts = 0;
+    dutyHoldTime = 0;
+    dutyOpen = false;
+    dutyHold = false;
+#endif
+    txStage = TX_STAGE_IDLE;
+    txFifoHead = 0;
+    txFifoTail = 0;
+    txFifoCount = 0;
+    txFifoFailed = false;
+    txReuse = false;
+    txCallback = NULL;
+    txSendingAck = false;
+#ifdef NRF_HAS_ENERGY_DETECT
+    txShorts = 0;
+#endif
+    memset(linkStats, 0, sizeof(linkStats));
+    memset(lastPacket, 0, sizeof(lastPacket));
+    activeProfile = NULL;
+    hopCount = 0;
+    hopTunedIndex = HOP_NOT_TUNED;
+#if defined NRF_HW_ACK_TIMING
+    txHwAck = false;
+    rxShorts = 0;
+    rxTurn = RX_TURN_NONE;
+    rxAckArmed = false;
+    rxAckStaged = false;
+    rxAckPipe = 0;
+    rxAckSlot = NULL;
+    ackTxAddress = 0;
+#endif
+    lastTxResult = false;
+#if defined NRF_CYCLE_STATS
+    memset(&cycleStats, 0, sizeof(cycleStats));
+    txStageStart = 0;
+#endif
 #ifndef ARDUINO_NRF54L15
     interframeSpacing = 115;
 #else
@@ -105,11 +258,19 @@ nrf_to_nrf::nrf_to_nrf()
 #endif
 
 #if defined CCM_ENCRYPTION_ENABLED
-    NRF_CCM->INPTR = (uint32_t)inBuffer;
-    NRF_CCM->OUTPTR = (uint32_t)outBuffer;
-    NRF_CCM->CNFPTR = (uint32_t)&ccmData;
-    NRF_CCM->SCRATCHPTR = (uint32_t)scratchPTR;
     ccmData.counter = 12345;
+    memset(replayWindows, 0, sizeof(replayWindows));
+    replayProtection = false;
+    ccmBusy = false;
+    ccmDecrypting = false;
+    #if defined NRF_RNG_POOL
+    rngPoolHead = 0;
+    rngPoolTail = 0;
+    rngPoolCount = 0;
+    rngBytesGenerated = 0;
+    rngIVsTaken = 0;
+    rngUnderruns = 0;
+    #endif
     enableEncryption = false;
 #endif
 };
@@ -181,6 +342,24 @@ bool nrf_to_nrf::begin()
     // Enable auto ack on all pipes by default
     setAutoAck(1);
 
+#if defined NRF_HW_ACK_TIMING
+    setupAckTimer();
+#endif
+
+#if defined NRF_CYCLE_STATS && defined DWT
+    // Start the cycle counter read by NRF_CYCLE_CLOCK()
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
+#if defined NRF_RADIO_IRQ_ENABLED
+    radioInstance = this;
+    NRF_RADIO->RADIO_INTENCLR = 0xFFFFFFFF;
+    NVIC_ClearPendingIRQ(RADIO_IRQ_NUMBER);
+    NVIC_SetPriority(RADIO_IRQ_NUMBER, NRF_RADIO_IRQ_PRIORITY);
+    NVIC_EnableIRQ(RADIO_IRQ_NUMBER);
+#endif
+
 #ifdef ARDUINO_NRF54L15
     NRF_RADIO->TASKS_START = 1;
 #endif
@@ -191,7 +370,8 @@ bool nrf_to_nrf::begin()
 /**********************************************************************************************************/
 
 #ifdef NRF_HAS_ENERGY_DETECT
-    #define ED_RSSISCALE 4 // From electrical specifications
+    #define ED_RSSISCALE 4  // From electrical specifications
+    #define ED_RSSIOFFS  93 // EDSAMPLE 0 is -93dBm, 1dB per step
 uint8_t nrf_to_nrf::sample_ed(void)
 {
     int val;
@@ -218,88 +398,158 @@ bool nrf_to_nrf::available()
 
 bool nrf_to_nrf::available(uint8_t* pipe_num)
 {
+    if (txStage != TX_STAGE_IDLE) {
+        updateTx();
+    }
+#if !defined NRF_RADIO_IRQ_ENABLED
+    else {
+    #if defined NRF_HW_ACK_TIMING
+        // Back to RX after the last ACK, also with the FIFO full
+        if (rxTurn != RX_TURN_NONE) {
+            hwAckUpdate();
+        }
+    #endif
+        // Move any newly received packet into the FIFO first so the radio can be restarted right away
+        if (rxFifoCount < NRF_RX_FIFO_SIZE) {
+            processRxPacket();
+        }
+    }
+#else
+    if (rxAckDeferred && txStage == TX_STAGE_IDLE) {
+        // The RX interrupts stay off until the packet has been handled here
+        rxAckDeferred = false;
+        processRxPacket();
+        if (inRxMode && txStage == TX_STAGE_IDLE) {
+            NRF_RADIO->RADIO_INTENSET = RADIO_IRQ_RX_MASK;
+        }
+    }
+#endif
+    if (hopCount && txStage == TX_STAGE_IDLE) {
+        hopListen();
+    }
+#if defined NRF_DUTY_CYCLE
+    if (dutyWindowTicks && txStage == TX_STAGE_IDLE) {
+        dutyUpdate();
+    }
+#endif
 
-    if (payloadAvailable) {
-        *pipe_num = (uint8_t)NRF_RADIO->RXMATCH;
+    if (rxFifoCount) {
+        *pipe_num = rxFifo[rxFifoHead].pipe;
         return true;
     }
+    return 0;
+}
+
+/**********************************************************************************************************/
+
+bool nrf_to_nrf::processRxPacket()
+{
 
-    if (!inRxMode) {
-        if (ackPayloadAvailable) {
-            *pipe_num = ackAvailablePipeNo;
-            return true;
-        }
-    }
     if (NRF_RADIO->EVENTS_CRCOK) {
         NRF_RADIO->EVENTS_CRCOK = 0;
+        NRF_STAGE_START(rxStart);
+        uint32_t rxTime = hopCount ? micros() : 0;
+#ifndef ARDUINO_NRF54L15
+        // Taken by the ADDRESS_RSSISTART short, read it before an ACK is sent
+        uint8_t rssi = (uint8_t)NRF_RADIO->RSSISAMPLE;
+#else
+        uint8_t rssi = 0;
+#endif
+        rxFifoSlot_t* slot = &rxFifo[rxFifoTail];
+        uint8_t* frame = slot->frame;
+        if (rxFrame != frame) {
+            // Received into the overflow buffer (FIFO was full) or a rejected packet left the slot unused
+            memcpy(frame, rxFrame, sizeof(slot->frame));
+            if (rxFrame == radioData) {
+                linkStats[NRF_RADIO->RXMATCH].rxFifoFull++;
+            }
+        }
+        rxBusy = true;
+
         if (DPL) {
-            if (radioData[0] > ACTUAL_MAX_PAYLOAD_SIZE - (2 + NRF_RADIO->CRCCNF) || radioData[0] == 0) {
+            if (frame[0] > ACTUAL_MAX_PAYLOAD_SIZE - (2 + NRF_RADIO->CRCCNF) || frame[0] == 0) {
                 return restartReturnRx();
             }
         }
 
-        *pipe_num = (uint8_t)NRF_RADIO->RXMATCH;
-        if (!DPL && acksEnabled(*pipe_num) == false) {
-#if defined CCM_ENCRYPTION_ENABLED
-            if (enableEncryption) {
-                memcpy(&rxBuffer[1], &radioData[CCM_IV_SIZE + CCM_COUNTER_SIZE], staticPayloadSize - CCM_IV_SIZE - CCM_COUNTER_SIZE);
-                memcpy(ccmData.iv, &radioData[0], CCM_IV_SIZE);
-                memcpy(&ccmData.counter, &radioData[CCM_IV_SIZE], CCM_COUNTER_SIZE);
-            }
-            else {
-#endif
-                memcpy(&rxBuffer[1], &radioData[0], staticPayloadSize);
-#if defined CCM_ENCRYPTION_ENABLED
-            }
-#endif
+        uint8_t pipe_num = (uint8_t)NRF_RADIO->RXMATCH;
+        uint8_t dataStart = (!DPL && acksEnabled(pipe_num) == false) ? 0 : 2;
+
+        // Hopping nodes end their data packets with the sender's slot phase, see enableHopping()
+        bool hopFrame = hopCount && DPL;
+        uint8_t hopPhase = hopFrame ? frame[1 + frame[0]] : 0;
+
+        uint8_t packetCtr = 0;
+        if (DPL) {
+            packetCtr = frame[1];
+            slot->length = frame[0] - hopFrame;
         }
         else {
+            packetCtr = frame[0];
+            slot->length = staticPayloadSize;
+        }
+
+        ackPID = packetCtr;
+        // The slot phase changes between retransmissions, so it is left out of the checksum
+        uint16_t packetData = (NRF_RADIO->CRCCNF && !hopFrame) ? (uint16_t)NRF_RADIO->RXCRC : frameChecksum(frame, slot->length + dataStart);
+        dedupEntry_t* last = &lastPacket[pipe_num];
+        bool duplicate = last->valid && packetCtr == last->pid && packetData == last->crc;
 #if defined CCM_ENCRYPTION_ENABLED
-            if (enableEncryption) {
-                if (DPL) {
-                    memcpy(&rxBuffer[1], &radioData[2 + CCM_IV_SIZE + CCM_COUNTER_SIZE], max(0, (int8_t)radioData[0] - CCM_IV_SIZE - CCM_COUNTER_SIZE));
-                }
-                else {
-                    memcpy(&rxBuffer[1], &radioData[CCM_IV_SIZE + CCM_COUNTER_SIZE], max(0, (int8_t)staticPayloadSize - CCM_IV_SIZE - CCM_COUNTER_SIZE));
+        uint32_t counter = 0;
+        if (enableEncryption) {
+            if ((DPL ? slot->length : staticPayloadSize) < CCM_IV_SIZE + CCM_COUNTER_SIZE + CCM_MIC_SIZE) {
+                // Too short to hold the IV, counter & MIC, so it can't decrypt. Dropped before it is ACKed.
+                linkStats[pipe_num].rxDecryptFailures++;
+                return restartReturnRx();
+            }
+            memcpy(ccmData.iv, &frame[dataStart], CCM_IV_SIZE);
+            memcpy(&ccmData.counter, &frame[dataStart + CCM_IV_SIZE], CCM_COUNTER_SIZE);
+            counter = (uint32_t)ccmData.counter & CCM_COUNTER_MASK;
+            dataStart += CCM_IV_SIZE + CCM_COUNTER_SIZE;
+
+            if (!replayCheck(pipe_num, counter)) {
+                if (!duplicate || !acksEnabled(pipe_num)) {
+                    // Not a retransmission of the last packet, don't ACK or decrypt it
+                    linkStats[pipe_num].rxReplays++;
+                    return restartReturnRx();
                 }
-                memcpy(ccmData.iv, &radioData[2], CCM_IV_SIZE);
-                memcpy(&ccmData.counter, &radioData[2 + CCM_IV_SIZE], CCM_COUNTER_SIZE);
+                // A retransmission after a lost ACK is ACKed again, then dropped as a duplicate without using the CCM
             }
             else {
-#endif
+                uint8_t bufferLength = 0;
                 if (DPL) {
-                    memcpy(&rxBuffer[1], &radioData[2], radioData[0]);
+                    bufferLength = slot->length - CCM_IV_SIZE - CCM_COUNTER_SIZE;
                 }
                 else {
-                    memcpy(&rxBuffer[1], &radioData[2], staticPayloadSize);
+                    bufferLength = staticPayloadSize - CCM_IV_SIZE - CCM_COUNTER_SIZE;
                 }
-#if defined CCM_ENCRYPTION_ENABLED
+                // The counter has been copied out, so its bytes become the CCM header and the ciphertext is read
+                // straight from the RX slot. Decryption then runs while the ACK is being sent.
+                ccmStart(&frame[dataStart - CCM_START_SIZE], bufferLength, true);
             }
-#endif
-        }
-
-        rxFifoAvailable = true;
-        uint8_t packetCtr = 0;
-        if (DPL) {
-            packetCtr = radioData[1];
-            rxBuffer[0] = radioData[0];
-        }
-        else {
-            packetCtr = radioData[0];
-            rxBuffer[0] = staticPayloadSize;
         }
-
-        ackPID = packetCtr;
-        uint16_t packetData = NRF_RADIO->RXCRC;
+#endif
         // If ack is enabled on this receiving pipe
         if (acksEnabled(NRF_RADIO->RXMATCH)) {
+            NRF_STAGE_START(ackStart);
+#if defined NRF_HW_ACK_TIMING
+            if (DPL) {
+                sendHwAck(pipe_num, duplicate);
+            }
+            else {
+#endif
             stopListening(false, false);
+            // ACKs are sent with write(), but should not be reported to the user's TX callback or counted as payloads
+            void (*callback)(bool, uint8_t) = txCallback;
+            txCallback = NULL;
+            txSendingAck = true;
             uint32_t txAddress = NRF_RADIO->TXADDRESS;
             NRF_RADIO->TXADDRESS = NRF_RADIO->RXMATCH;
             delayMicroseconds(75);
             if (ackPayloadsEnabled) {
-                if (*pipe_num == ackPipe) {
-                    write(&ackBuffer[1], ackBuffer[0], 1, 0);
+                ackSlot_t* ack = nextAckPayload(pipe_num, duplicate);
+                if (ack != NULL) {
+                    write(ack->data, ack->length, 1, 0);
                 }
                 else {
                     write(0, 0, 1, 0);
@@ -317,277 +567,530 @@ bool nrf_to_nrf::available(uint8_t* pipe_num)
                 }
             }
             NRF_RADIO->TXADDRESS = txAddress;
+            txCallback = callback;
+            txSendingAck = false;
             startListening(false);
+#if defined NRF_HW_ACK_TIMING
+            }
+#endif
+            NRF_STAGE_END(NRF_STAGE_RX_ACK, ackStart);
 
-            // If the packet has the same ID number and data, it is most likely a
-            // duplicate
-            if (NRF_RADIO->CRCCNF != 0) { // If CRC enabled, check this data
-                if (packetCtr == lastPacketCounter && packetData == lastData) {
-                    return restartReturnRx();
-                }
+            // If the packet has the same ID number and data as the last one on this pipe, it is most likely a
+            // retransmission after a lost ACK
+            if (duplicate) {
+                linkStats[pipe_num].rxDuplicates++;
+                return restartReturnRx();
             }
         }
 
 #if defined CCM_ENCRYPTION_ENABLED
         if (enableEncryption) {
-            uint8_t bufferLength = 0;
-            if (DPL) {
-                bufferLength = rxBuffer[0] - CCM_IV_SIZE - CCM_COUNTER_SIZE;
-            }
-            else {
-                bufferLength = staticPayloadSize - CCM_IV_SIZE - CCM_COUNTER_SIZE;
-            }
-            if (!decrypt(&rxBuffer[1], bufferLength)) {
-                Serial.println("DECRYPT FAIL");
+            NRF_STAGE_START(decryptStart);
+            uint8_t plainLength = ccmFinish();
+            NRF_STAGE_END(NRF_STAGE_DECRYPT, decryptStart);
+            if (!plainLength) {
+                linkStats[pipe_num].rxDecryptFailures++;
                 return restartReturnRx();
             }
+            replayAccept(pipe_num, counter);
 
-            memset(&rxBuffer[1], 0, sizeof(rxBuffer) - 1);
+            // Put the plaintext back in place of the ciphertext
+            memcpy(&frame[dataStart], &outBuffer[CCM_START_SIZE], plainLength);
+            memset(&frame[dataStart + plainLength], 0, sizeof(slot->frame) - dataStart - plainLength);
 
             if (DPL) {
-                rxBuffer[0] -= (CCM_MIC_SIZE + CCM_IV_SIZE + CCM_COUNTER_SIZE);
-                memcpy(&rxBuffer[1], &outBuffer[CCM_START_SIZE], rxBuffer[0]);
-            }
-            else {
-                memcpy(&rxBuffer[1], &outBuffer[CCM_START_SIZE], staticPayloadSize - (CCM_MIC_SIZE - CCM_IV_SIZE - CCM_COUNTER_SIZE));
+                slot->length -= (CCM_MIC_SIZE + CCM_IV_SIZE + CCM_COUNTER_SIZE);
             }
         }
 #endif
-        lastPacketCounter = packetCtr;
-        lastData = packetData;
+        lastPacket[pipe_num].pid = packetCtr;
+        lastPacket[pipe_num].crc = packetData;
+        lastPacket[pipe_num].valid = true;
+        if (hopFrame) {
+            hopSync(hopPhase, rxTime, frame[0]);
+        }
 
-        if (inRxMode && !acksEnabled(NRF_RADIO->RXMATCH)) {
-            NRF_RADIO->TASKS_START = 1;
+        bool queued = (DPL && slot->length) || !DPL;
+        if (queued) {
+            slot->offset = dataStart;
+            slot->pipe = pipe_num;
+            slot->rssi = rssi;
+            rxFifoTail = (rxFifoTail + 1) % NRF_RX_FIFO_SIZE;
+            rxFifoCount++;
+            linkStats[pipe_num].rxPackets++;
         }
-        if ((DPL && rxBuffer[0]) || !DPL) {
-            payloadAvailable = true;
-            return 1;
+        rxBusy = false;
+
+        if (!acksEnabled(pipe_num)) {
+            restartReturnRx();
         }
+        NRF_STAGE_END(NRF_STAGE_RX, rxStart);
+        return queued;
     }
     if (NRF_RADIO->EVENTS_CRCERROR) {
         NRF_RADIO->EVENTS_CRCERROR = 0;
-        NRF_RADIO->TASKS_START = 1;
+        linkStats[NRF_RADIO->RXMATCH].rxCrcErrors++;
+        restartReturnRx();
     }
     return 0;
 }
 
 /**********************************************************************************************************/
 
-bool nrf_to_nrf::restartReturnRx()
+#if defined NRF_RADIO_IRQ_ENABLED
+void nrf_to_nrf::handleRadioIRQ()
 {
-    if (inRxMode) {
-        NRF_RADIO->TASKS_START = 1;
+    #if defined NRF_HW_ACK_TIMING
+    if (rxTurn != RX_TURN_NONE) {
+        hwAckUpdate();
+    }
+    #endif
+    if (txStage != TX_STAGE_IDLE) {
+        // Only the events the current TX stage waits for are enabled, including the ACK for our own transmission
+        advanceTx();
+    }
+    else if (rxFifoCount < NRF_RX_FIFO_SIZE) {
+        bool softAck = NRF_RADIO->EVENTS_CRCOK && acksEnabled(NRF_RADIO->RXMATCH);
+    #if defined NRF_HW_ACK_TIMING
+        softAck = softAck && !DPL;
+    #endif
+        if (softAck) {
+            // The software timed ACK blocks until it is sent, so it goes out from available() instead
+            NRF_RADIO->RADIO_INTENCLR = RADIO_IRQ_RX_MASK;
+            rxAckDeferred = true;
+        }
+        else {
+            processRxPacket();
+        }
+    }
+    else {
+        // Leave the packet un-ACKed, release() re-enables the interrupt once a slot is free
+        NRF_RADIO->RADIO_INTENCLR = RADIO_IRQ_RX_MASK;
     }
-    return 0;
 }
 
 /**********************************************************************************************************/
+#endif
 
-void nrf_to_nrf::read(void* buf, uint8_t len)
+uint16_t nrf_to_nrf::frameChecksum(const uint8_t* frame, uint16_t length)
 {
-    memcpy(buf, &rxBuffer[1], len);
-    ackPayloadAvailable = false;
-    payloadAvailable = false;
+    // Fletcher-16, only used to recognise retransmissions when the radio has CRC disabled
+    uint16_t sum1 = 0;
+    uint16_t sum2 = 0;
+    for (uint16_t i = 0; i < length; i++) {
+        sum1 = (sum1 + frame[i]) % 255;
+        sum2 = (sum2 + sum1) % 255;
+    }
+    return (sum2 << 8) | sum1;
 }
 
 /**********************************************************************************************************/
 
-bool nrf_to_nrf::write(void* buf, uint8_t len, bool multicast, bool doEncryption)
+bool nrf_to_nrf::restartReturnRx()
 {
-
-    uint8_t PID = ackPID;
-    if (DPL) {
-        PID = ((ackPID += 1) % 7) << 1;
+    rxBusy = false;
+#if defined NRF_HW_ACK_TIMING
+    if (inRxMode && (rxShorts & RADIO_SHORTS_END_DISABLE_Msk)) {
+        if (rxTurn != RX_TURN_NONE) {
+            // Dropped after sendHwAck(), hwAckUpdate() brings the radio back to RX after the ACK
+            return 0;
+        }
+        if (hwAckTaken()) {
+            // Dropped, but the timer has already started the ACK staged for it
+            sendHwAck(rxAckPipe, false);
+            return 0;
+        }
+        // No ACK for this packet, ramp back up to RX once the radio has disabled itself after it
+        disarmAckTimer();
+        hwAckReturn();
+        return 0;
     }
-    else {
-        PID = ackPID++;
+#endif
+    if (inRxMode) {
+        rxArm();
+        NRF_RADIO->TASKS_START = 1;
     }
-    uint8_t payloadSize = 0;
-
-#if defined CCM_ENCRYPTION_ENABLED
-
-    if (enableEncryption && doEncryption) {
-        if (len) {
-
-            for (int i = 0; i < CCM_IV_SIZE; i++) {
-                if (!waitForEvent(&NRF_RNG->EVENTS_VALRDY, 100))
-                    return 0;
-                NRF_RNG->EVENTS_VALRDY = 0;
-                ccmData.iv[i] = NRF_RNG->VALUE;
-            }
-            ccmData.counter = packetCounter;
+    return 0;
+}
 
-            if (!encrypt(buf, len)) {
-                return 0;
-            }
+/**********************************************************************************************************/
 
-            len += CCM_IV_SIZE + CCM_COUNTER_SIZE + CCM_MIC_SIZE;
-            packetCounter++;
-            if (packetCounter > 200000) {
-                packetCounter = 0;
-            }
+#if defined NRF_HW_ACK_TIMING
+void nrf_to_nrf::sendHwAck(uint8_t pipe, bool retransmit)
+{
+    // The radio disabled itself after the received packet & the ACK timer is running from its CRCOK. Usually the ACK
+    // was staged before the packet arrived & the timer has already ramped up to TX, or is about to.
+    bool timed = rxAckArmed && !(NRF_PPI->CHEN & (1UL << NRF_ACK_PPI_CH));
+    NRF_PPI->CHENCLR = 1 << NRF_ACK_PPI_CH;
+    if (rxAckStaged && rxAckPipe == pipe) {
+        if (rxAckSlot != NULL && rxAckSlot->pipe == pipe) {
+            // The pipe had no payload outstanding, so this is what nextAckPayload() would have returned
+            ackSentPipes |= 1 << pipe;
         }
     }
-#endif
-
-    for (int i = 0; i < (retries + 1); i++) {
-        arcCounter = i;
-        if (DPL) {
-            radioData[0] = len;
-            radioData[1] = PID;
+    else {
+        // Put in place now, the timer ramps up to TX interframeSpacing after the packet once the channel is enabled
+        loadHwAck(pipe, ackPayloadsEnabled ? nextAckPayload(pipe, retransmit) : NULL);
+        NRF_PPI->CHENSET = 1 << (NRF_ACK_PPI_CH + 3);
+    }
+    rxAckStaged = false;
+    rxAckArmed = false;
+    if (!NRF_RADIO->EVENTS_READY && (!timed || NRF_ACK_TIMER->EVENTS_COMPARE[0])) {
+        // Recovery only: too late for the timer, or the packet ended before it was armed. Ignored while ramping up.
+        NRF_ACK_TIMER->TASKS_CAPTURE[1] = 1;
+        if (timed && NRF_ACK_TIMER->CC[1] >= NRF_ACK_PEER_TURNAROUND) {
+            // The sender has given up on this ACK & could take it for the ACK of its next packet. The payload goes
+            // out again with the ACK for the retransmission.
+            NRF_PPI->CHENCLR = 1 << (NRF_ACK_PPI_CH + 3);
+            NRF_RADIO->TXADDRESS = ackTxAddress;
+            hwAckReturn();
+            return;
         }
-        else {
-            radioData[1] = 0;
-            radioData[0] = PID;
+        // The radio can still be disabling after the packet, the one-shot DISABLED channel ramps up once it has
+        NRF_PPI->CH[NRF_ACK_PPI_CH + 1].TEP = (uint32_t)&NRF_RADIO->TASKS_TXEN;
+        NRF_PPI->CHG[NRF_ACK_PPI_RX_GROUP] = 1 << (NRF_ACK_PPI_CH + 1);
+        NRF_PPI->CHENSET = 1 << (NRF_ACK_PPI_CH + 1);
+        if (NRF_RADIO->STATE == RADIO_STATE_STATE_Disabled) {
+            NRF_PPI->CHENCLR = 1 << (NRF_ACK_PPI_CH + 1);
+            NRF_RADIO->TASKS_TXEN = 1;
         }
+    }
+    rxTurn = RX_TURN_ACK;
+    #if defined NRF_RADIO_IRQ_ENABLED
+    NRF_RADIO->RADIO_INTENSET = RADIO_INTENSET_READY_Msk;
+    #endif
+}
 
-        uint8_t dataStart = 0;
+/**********************************************************************************************************/
 
-#if defined CCM_ENCRYPTION_ENABLED
+void nrf_to_nrf::loadHwAck(uint8_t pipe, ackSlot_t* ack)
+{
+    if (!rxAckStaged) {
+        ackTxAddress = NRF_RADIO->TXADDRESS;
+    }
+    NRF_RADIO->TXADDRESS = pipe;
+    if (ack != NULL) {
+        prepareTx(&ackFrame, ack->data, ack->length, 1, 0);
+    }
+    else {
+        prepareTx(&ackFrame, NULL, 0, 1, 0);
+    }
+    // RX has already latched its own PACKETPTR, this one is only used by the ACK's START
+    NRF_RADIO->PACKETPTR = (uint32_t)ackFrame.data;
+}
 
-        if (enableEncryption && doEncryption) {
-            dataStart = (!DPL && acksEnabled(0) == false) ? CCM_IV_SIZE + CCM_COUNTER_SIZE : CCM_IV_SIZE + CCM_COUNTER_SIZE + 2;
-        }
-        else {
-#endif
-            dataStart = (!DPL && acksEnabled(0) == false) ? 0 : 2;
-#if defined CCM_ENCRYPTION_ENABLED
-        }
-#endif
+/**********************************************************************************************************/
 
-#if defined CCM_ENCRYPTION_ENABLED
-        if (enableEncryption && doEncryption) {
-            memcpy(&radioData[dataStart - CCM_COUNTER_SIZE], &ccmData.counter, CCM_COUNTER_SIZE);
-            memcpy(&radioData[dataStart - CCM_IV_SIZE - CCM_COUNTER_SIZE], ccmData.iv, CCM_IV_SIZE);
-            memcpy(&radioData[dataStart], &outBuffer[CCM_START_SIZE], len - (CCM_IV_SIZE + CCM_COUNTER_SIZE));
-        }
-        else {
-#endif
-            memcpy(&radioData[dataStart], buf, len);
-#if defined CCM_ENCRYPTION_ENABLED
-        }
-#endif
-#ifdef ARDUINO_NRF54L15
-        uint32_t timeout = millis();
-        while (NRF_RADIO->STATE != 10) {
-            yield();
-            if (millis() - timeout > 250) {
-                return 0;
-            }
+void nrf_to_nrf::stageHwAck()
+{
+    // The ACK can be staged before the packet when nothing in it depends on the packet: only one pipe is listening &
+    // the pipe has no ACK payload outstanding, so a retransmission gets the same ACK as a new packet. Encrypted
+    // packets are checked before they are ACKed & a full RX FIFO holds ACKs back, sendHwAck() handles those.
+    uint32_t pipes = NRF_RADIO->RXADDRESSES & 0xFF;
+    if (!pipes || (pipes & (pipes - 1)) || rxFrame == radioData) {
+        return;
+    }
+    #if defined CCM_ENCRYPTION_ENABLED
+    if (enableEncryption) {
+        return;
+    }
+    #endif
+    #if defined NRF_DUTY_CYCLE
+    if (dutyWindowTicks) {
+        // The RTC restarts RX by itself, PACKETPTR has to stay on the RX slot
+        return;
+    }
+    #endif
+    uint8_t pipe = 0;
+    while (!(pipes & (1 << pipe))) {
+        pipe++;
+    }
+    if (!acksPerPipe[pipe] || (ackPayloadsEnabled && (ackSentPipes & (1 << pipe)))) {
+        return;
+    }
+    ackSlot_t* ack = NULL;
+    for (uint8_t i = 0; ackPayloadsEnabled && ack == NULL && i < ackCount; i++) {
+        if (ackSlots[ackOrder[i]].pipe == pipe) {
+            ack = &ackSlots[ackOrder[i]];
         }
-#endif
-        NRF_RADIO->EVENTS_END = 0;
-        NRF_RADIO->TASKS_START = 1;
-        if (!waitForEvent(&NRF_RADIO->EVENTS_END))
-            return false;
-
-        NRF_RADIO->EVENTS_END = 0;
-        if (!multicast && acksPerPipe[NRF_RADIO->TXADDRESS] == true) {
-            uint32_t rxAddress = NRF_RADIO->RXADDRESSES;
-            NRF_RADIO->RXADDRESSES = 1 << NRF_RADIO->TXADDRESS;
-            if (!DPL) {
-                payloadSize = getPayloadSize();
-                setPayloadSize(0);
-            }
-            startListening(false);
-
-            int32_t realAckTimeout = (int32_t)ackTimeout;
-            if (!DPL) {
-                if (NRF_RADIO->MODE == (RADIO_MODE_MODE_Nrf_1Mbit << RADIO_MODE_MODE_Pos)) {
-                    realAckTimeout -= ACK_TIMEOUT_1MBPS_OFFSET;
-                }
-                else if (NRF_RADIO->MODE == (RADIO_MODE_MODE_Nrf_250Kbit << RADIO_MODE_MODE_Pos)) {
-                    realAckTimeout -= ACK_TIMEOUT_250KBPS_OFFSET;
-                }
-                else {
-                    realAckTimeout -= ACK_TIMEOUT_2MBPS_OFFSET;
-                }
-            }
-            else {
-                if (ackPayloadsEnabled && staticPayloadSize <= DEFAULT_MAX_PAYLOAD_SIZE) {
-                    realAckTimeout += 200;
-                }
-                else {
-                    realAckTimeout += ACK_PAYLOAD_TIMEOUT_OFFSET;
-                }
-            }
-            if (realAckTimeout < 0) {
-                realAckTimeout = 0;
-            }
+    }
+    loadHwAck(pipe, ack);
+    rxAckStaged = true;
+    rxAckPipe = pipe;
+    rxAckSlot = ack;
+    NRF_PPI->CHENSET = 1 << (NRF_ACK_PPI_CH + 3);
+}
 
-            uint32_t ack_timeout = micros();
-            while (!NRF_RADIO->EVENTS_CRCOK && !NRF_RADIO->EVENTS_CRCERROR) {
-                if (micros() - ack_timeout > realAckTimeout) {
-                    break;
-                }
-            }
-            if (NRF_RADIO->EVENTS_CRCOK) {
-                if (ackPayloadsEnabled && radioData[0] > 0) {
-#if defined CCM_ENCRYPTION_ENABLED
-                    if (enableEncryption && doEncryption) {
-                        memcpy(&rxBuffer[1], &radioData[2 + CCM_COUNTER_SIZE + CCM_IV_SIZE], max(0, radioData[0] - CCM_COUNTER_SIZE - CCM_IV_SIZE));
-                    }
-                    else {
-                        memcpy(&rxBuffer[1], &radioData[2], radioData[0]);
-                    }
-#else
-                    memcpy(&rxBuffer[1], &radioData[2], radioData[0]);
-#endif
+/**********************************************************************************************************/
 
-#if defined CCM_ENCRYPTION_ENABLED
-                    if (enableEncryption && radioData[0] > 0) {
-                        memcpy(ccmData.iv, &radioData[2], CCM_IV_SIZE);
-                        memcpy(&ccmData.counter, &radioData[2 + CCM_IV_SIZE], CCM_COUNTER_SIZE);
-
-                        if (!decrypt(&rxBuffer[1], radioData[0])) {
-                            Serial.println("DECRYPT FAIL");
-                            return 0;
-                        }
-                        if (radioData[0] >= CCM_MIC_SIZE + CCM_COUNTER_SIZE + CCM_IV_SIZE) {
-                            radioData[0] -= CCM_MIC_SIZE + CCM_COUNTER_SIZE + CCM_IV_SIZE;
-                        }
-                        memcpy(&rxBuffer[1], &outBuffer[CCM_START_SIZE], radioData[0]);
-                    }
-#endif
-                    rxBuffer[0] = radioData[0];
-                    ackPayloadAvailable = true;
-                    ackAvailablePipeNo = NRF_RADIO->RXMATCH;
-                }
-                NRF_RADIO->EVENTS_CRCOK = 0;
-                stopListening(false, false);
-                if (!DPL) {
-                    setPayloadSize(payloadSize);
-                }
-                NRF_RADIO->RXADDRESSES = rxAddress;
-                lastTxResult = true;
-                return 1;
-            }
-            else if (NRF_RADIO->EVENTS_CRCERROR) {
-                NRF_RADIO->EVENTS_CRCERROR = 0;
-            }
-            uint32_t duration = 258 * retryDuration;
-            delayMicroseconds(duration);
-            stopListening(false, false);
-            if (!DPL) {
-                setPayloadSize(payloadSize);
+void nrf_to_nrf::restageHwAck()
+{
+    // Called when the pipes or ACK payloads change while listening. An ACK whose packet has already ended is left as
+    // it is for sendHwAck().
+    #if defined NRF_RADIO_IRQ_ENABLED
+    NVIC_DisableIRQ(RADIO_IRQ_NUMBER);
+    #endif
+    if (rxAckArmed && rxTurn == RX_TURN_NONE) {
+        NRF_PPI->CHENCLR = 1 << (NRF_ACK_PPI_CH + 3);
+        if (!(NRF_PPI->CHEN & (1UL << NRF_ACK_PPI_CH))) {
+            if (rxAckStaged) {
+                NRF_PPI->CHENSET = 1 << (NRF_ACK_PPI_CH + 3);
             }
-            NRF_RADIO->RXADDRESSES = rxAddress;
         }
         else {
-            lastTxResult = true;
-            return 1;
+            if (rxAckStaged) {
+                NRF_RADIO->TXADDRESS = ackTxAddress;
+                rxAckStaged = false;
+            }
+            stageHwAck();
         }
     }
-    lastTxResult = false;
-    return 0;
+    #if defined NRF_RADIO_IRQ_ENABLED
+    NVIC_EnableIRQ(RADIO_IRQ_NUMBER);
+    #endif
 }
 
 /**********************************************************************************************************/
 
-bool nrf_to_nrf::startWrite(void* buf, uint8_t len, bool multicast, bool doEncryption)
+bool nrf_to_nrf::hwAckTaken()
 {
+    // The timer channel disables its own group when the packet's CRCOK starts it, its compare then sends the staged ACK
+    return rxAckStaged && rxAckArmed && !(NRF_PPI->CHEN & (1UL << NRF_ACK_PPI_CH));
+}
 
-    uint8_t PID = ackPID;
+/**********************************************************************************************************/
+
+void nrf_to_nrf::hwAckReturn()
+{
+    // The next packet goes into the next free slot. The one-shot DISABLED -> RXEN channel ramps back up to RX once the
+    // radio has disabled itself after the ACK or the dropped packet, READY_START then starts receiving into it.
+    rxArm();
+    NRF_RADIO->EVENTS_RXREADY = 0;
+    NRF_PPI->CH[NRF_ACK_PPI_CH + 1].TEP = (uint32_t)&NRF_RADIO->TASKS_RXEN;
+    NRF_PPI->CHG[NRF_ACK_PPI_RX_GROUP] = 1 << (NRF_ACK_PPI_CH + 1);
+    NRF_PPI->CHENSET = 1 << (NRF_ACK_PPI_CH + 1);
+    if (NRF_RADIO->STATE == RADIO_STATE_STATE_Disabled) {
+        NRF_PPI->CHENCLR = 1 << (NRF_ACK_PPI_CH + 1);
+        NRF_RADIO->TASKS_RXEN = 1;
+    }
+    rxTurn = RX_TURN_RX;
+    #if defined NRF_RADIO_IRQ_ENABLED
+    NRF_RADIO->RADIO_INTENCLR = RADIO_INTENSET_READY_Msk;
+    NRF_RADIO->RADIO_INTENSET = RADIO_INTENSET_RXREADY_Msk;
+    #endif
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::hwAckUpdate()
+{
+    if (rxTurn == RX_TURN_ACK && NRF_RADIO->EVENTS_READY) {
+        // READY_START has started the ACK & latched its TXADDRESS & PACKETPTR, both can be changed for RX again
+        NRF_RADIO->TXADDRESS = ackTxAddress;
+        hwAckReturn();
+    }
+    if (rxTurn == RX_TURN_RX && NRF_RADIO->EVENTS_RXREADY) {
+        rxTurn = RX_TURN_NONE;
+    #if defined NRF_RADIO_IRQ_ENABLED
+        NRF_RADIO->RADIO_INTENCLR = RADIO_INTENSET_RXREADY_Msk;
+    #endif
+        armAckTurnaround();
+    }
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::hwAckFinish()
+{
+    // Let an ACK on its way go out with the settings of the packet it answers & the radio get back to RX before it
+    // is switched over or reconfigured
+    if (rxTurn == RX_TURN_NONE) {
+        return;
+    }
+    #if defined NRF_RADIO_IRQ_ENABLED
+    NVIC_DisableIRQ(RADIO_IRQ_NUMBER);
+    #endif
+    uint32_t start = millis();
+    while (rxTurn != RX_TURN_NONE && millis() - start <= DEFAULT_TIMEOUT) {
+        hwAckUpdate();
+    }
+    if (rxTurn == RX_TURN_ACK) {
+        NRF_RADIO->TXADDRESS = ackTxAddress;
+    }
+    rxTurn = RX_TURN_NONE;
+    #if defined NRF_RADIO_IRQ_ENABLED
+    NRF_RADIO->RADIO_INTENCLR = RADIO_IRQ_ACK_MASK;
+    NVIC_EnableIRQ(RADIO_IRQ_NUMBER);
+    #endif
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::armAckTimer(uint32_t timeout)
+{
+    NRF_ACK_TIMER->TASKS_STOP = 1;
+    NRF_ACK_TIMER->TASKS_CLEAR = 1;
+    NRF_ACK_TIMER->EVENTS_COMPARE[0] = 0;
+    NRF_ACK_TIMER->SHORTS = TIMER_SHORTS_COMPARE0_STOP_Msk;
+    NRF_ACK_TIMER->CC[0] = timeout;
+    NRF_PPI->CH[NRF_ACK_PPI_CH].EEP = (uint32_t)&NRF_RADIO->EVENTS_END;
+    NRF_PPI->CH[NRF_ACK_PPI_CH + 1].TEP = (uint32_t)&NRF_RADIO->TASKS_RXEN;
+    NRF_PPI->CH[NRF_ACK_PPI_CH + 3].TEP = (uint32_t)&NRF_RADIO->TASKS_DISABLE;
+
+    // The END->START and DISABLED->RXEN channels are one-shot, each disables its own group when triggered. The
+    // DISABLED->RXEN one is only enabled by txStarted(), once PACKETPTR is off the frame.
+    NRF_PPI->CHG[NRF_ACK_PPI_GROUP] = 1 << NRF_ACK_PPI_CH;
+    NRF_PPI->CHG[NRF_ACK_PPI_RX_GROUP] = 1 << (NRF_ACK_PPI_CH + 1);
+    NRF_PPI->CHENSET = 0xD << NRF_ACK_PPI_CH;
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::armAckTurnaround()
+{
+    // While receiving, the CRCOK of the next packet starts the timer & its compare ramps up to TX for the ACK. The
+    // compare channel is only enabled once the ACK frame is in place, so a packet nobody prepared an ACK for is never
+    // answered with whatever PACKETPTR points at. Packets failing the CRC don't start the timer at all.
+    uint32_t rampUp = (NRF_RADIO->MODECNF0 & 1) ? RAMP_UP_FAST_US : RAMP_UP_DEFAULT_US;
+    disarmAckTimer();
+    NRF_ACK_TIMER->TASKS_CLEAR = 1;
+    NRF_ACK_TIMER->SHORTS = 0; // Counts on past the compare, so sendHwAck() can tell how late it is
+    NRF_ACK_TIMER->CC[0] = interframeSpacing > rampUp ? interframeSpacing - rampUp : 1;
+    NRF_PPI->CH[NRF_ACK_PPI_CH].EEP = (uint32_t)&NRF_RADIO->EVENTS_CRCOK;
+    NRF_PPI->CH[NRF_ACK_PPI_CH + 3].TEP = (uint32_t)&NRF_RADIO->TASKS_TXEN;
+    NRF_PPI->CHG[NRF_ACK_PPI_GROUP] = 1 << NRF_ACK_PPI_CH;
+    NRF_RADIO->EVENTS_READY = 0; // Set again by the ACK ramping up to TX
+    rxAckArmed = true;
+    NRF_PPI->CHENSET = 1 << NRF_ACK_PPI_CH;
+    stageHwAck();
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::disarmAckTimer()
+{
+    NRF_PPI->CHENCLR = 0xF << NRF_ACK_PPI_CH;
+    NRF_ACK_TIMER->TASKS_STOP = 1;
+    NRF_ACK_TIMER->EVENTS_COMPARE[0] = 0;
+    if (rxAckStaged) {
+        NRF_RADIO->TXADDRESS = ackTxAddress;
+        rxAckStaged = false;
+    }
+    rxAckArmed = false;
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::setupAckTimer()
+{
+    NRF_ACK_TIMER->MODE = TIMER_MODE_MODE_Timer;
+    NRF_ACK_TIMER->BITMODE = TIMER_BITMODE_BITMODE_32Bit;
+    NRF_ACK_TIMER->PRESCALER = 4; // 1MHz, 1 tick per uS
+    NRF_ACK_TIMER->SHORTS = TIMER_SHORTS_COMPARE0_STOP_Msk;
+
+    // TX END: start the ACK timeout. While receiving, armAckTurnaround() starts it from CRCOK to send ACKs instead
+    NRF_PPI->CH[NRF_ACK_PPI_CH].EEP = (uint32_t)&NRF_RADIO->EVENTS_END;
+    NRF_PPI->CH[NRF_ACK_PPI_CH].TEP = (uint32_t)&NRF_ACK_TIMER->TASKS_START;
+    NRF_PPI->FORK[NRF_ACK_PPI_CH].TEP = (uint32_t)&NRF_PPI->TASKS_CHG[NRF_ACK_PPI_GROUP].DIS;
+    // TX DISABLED: switch to RX straight away to wait for the ACK. While receiving, ramps up for or back from ACKs
+    NRF_PPI->CH[NRF_ACK_PPI_CH + 1].EEP = (uint32_t)&NRF_RADIO->EVENTS_DISABLED;
+    NRF_PPI->CH[NRF_ACK_PPI_CH + 1].TEP = (uint32_t)&NRF_RADIO->TASKS_RXEN;
+    NRF_PPI->FORK[NRF_ACK_PPI_CH + 1].TEP = (uint32_t)&NRF_PPI->TASKS_CHG[NRF_ACK_PPI_RX_GROUP].DIS;
+    // ADDRESS: an ACK is being received, don't time out
+    NRF_PPI->CH[NRF_ACK_PPI_CH + 2].EEP = (uint32_t)&NRF_RADIO->EVENTS_ADDRESS;
+    NRF_PPI->CH[NRF_ACK_PPI_CH + 2].TEP = (uint32_t)&NRF_ACK_TIMER->TASKS_STOP;
+    // Timeout: stop listening for the ACK. While receiving, armAckTurnaround() points it at TXEN to send ACKs instead
+    NRF_PPI->CH[NRF_ACK_PPI_CH + 3].EEP = (uint32_t)&NRF_ACK_TIMER->EVENTS_COMPARE[0];
+    NRF_PPI->CH[NRF_ACK_PPI_CH + 3].TEP = (uint32_t)&NRF_RADIO->TASKS_DISABLE;
+}
+
+/**********************************************************************************************************/
+#endif
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::read(void* buf, uint8_t len)
+{
+    uint8_t length = 0;
+    uint8_t pipe = 0;
+    const uint8_t* payload = peek(&length, &pipe);
+    if (payload == NULL) {
+        return;
+    }
+    memcpy(buf, payload, len);
+    release();
+}
+
+/**********************************************************************************************************/
+
+const uint8_t* nrf_to_nrf::peek(uint8_t* len, uint8_t* pipe)
+{
+    if (!rxFifoCount) {
+        return NULL;
+    }
+    rxFifoSlot_t* slot = &rxFifo[rxFifoHead];
+    *len = slot->length;
+    *pipe = slot->pipe;
+    return &slot->frame[slot->offset];
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::release()
+{
+    if (!rxFifoCount) {
+        return;
+    }
+    rxLastRSSI = rxFifo[rxFifoHead].rssi;
+    rxFifoHead = (rxFifoHead + 1) % NRF_RX_FIFO_SIZE;
+#if defined NRF_RADIO_IRQ_ENABLED
+    NVIC_DisableIRQ(RADIO_IRQ_NUMBER);
+    rxFifoCount--;
+    if (inRxMode && txStage == TX_STAGE_IDLE) {
+        NRF_RADIO->RADIO_INTENSET = RADIO_IRQ_RX_MASK;
+    }
+    NVIC_EnableIRQ(RADIO_IRQ_NUMBER);
+#else
+    rxFifoCount--;
+#endif
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::rxArm()
+{
+    // Receive straight into the next free FIFO slot, or into radioData if none are free
+    uint8_t used = rxFifoCount + (rxBusy ? 1 : 0);
+    if (used < NRF_RX_FIFO_SIZE) {
+        rxFrame = rxFifo[(rxFifoTail + (rxBusy ? 1 : 0)) % NRF_RX_FIFO_SIZE].frame;
+    }
+    else {
+        rxFrame = radioData;
+    }
+    NRF_RADIO->PACKETPTR = (uint32_t)rxFrame;
+}
+
+/**********************************************************************************************************/
+
+bool nrf_to_nrf::prepareTx(txFifoSlot_t* slot, void* buf, uint8_t len, bool multicast, bool doEncryption)
+{
+
+    // Data packets of hopping nodes end with the slot phase, ACKs are sent in the same slot as the packet
+    bool hopFrame = hopCount && DPL && slot != &ackFrame;
+    if (hopFrame) {
+        uint16_t frameLength = len + 1;
+#if defined CCM_ENCRYPTION_ENABLED
+        if (enableEncryption && doEncryption && len) {
+            frameLength += CCM_IV_SIZE + CCM_COUNTER_SIZE + CCM_MIC_SIZE;
+        }
+#endif
+        if (frameLength > ((NRF_RADIO->PCNF1 >> RADIO_PCNF1_MAXLEN_Pos) & 0xFF)) {
+            // The receiver would drop it, there is no room left for the phase byte
+            return 0;
+        }
+    }
+
+    uint8_t PID = ackPID;
     if (DPL) {
         PID = ((ackPID += 1) % 7) << 1;
     }
@@ -595,77 +1098,790 @@ bool nrf_to_nrf::startWrite(void* buf, uint8_t len, bool multicast, bool doEncry
         PID = ackPID++;
     }
 
+    bool encrypted = false;
+
 #if defined CCM_ENCRYPTION_ENABLED
-    uint8_t tmpIV[CCM_IV_SIZE];
-    uint32_t tmpCounter = 0;
 
     if (enableEncryption && doEncryption) {
         if (len) {
 
-            for (int i = 0; i < CCM_IV_SIZE; i++) {
-                if (!waitForEvent(&NRF_RNG->EVENTS_VALRDY, 100))
-                    return 0;
-                NRF_RNG->EVENTS_VALRDY = 0;
-                tmpIV[i] = NRF_RNG->VALUE;
-                ccmData.iv[i] = tmpIV[i];
+            NRF_STAGE_START(ivStart);
+            uint8_t iv[CCM_IV_SIZE];
+            if (!takeIV(iv)) {
+                return 0;
             }
-            tmpCounter = packetCounter;
-            ccmData.counter = tmpCounter;
+            NRF_STAGE_END(NRF_STAGE_IV, ivStart);
+
+            // Only called here from thread context (ACKs are not encrypted), where the RX interrupt would use the
+            // same CCM, IV, counter & output buffer. Held off until the ciphertext has been copied out below.
+#if defined NRF_RADIO_IRQ_ENABLED
+            NVIC_DisableIRQ(RADIO_IRQ_NUMBER);
+#endif
+            memcpy(ccmData.iv, iv, CCM_IV_SIZE);
+            ccmData.counter = packetCounter;
 
+            NRF_STAGE_START(encryptStart);
             if (!encrypt(buf, len)) {
+#if defined NRF_RADIO_IRQ_ENABLED
+                NVIC_EnableIRQ(RADIO_IRQ_NUMBER);
+#endif
                 return 0;
             }
+            NRF_STAGE_END(NRF_STAGE_ENCRYPT, encryptStart);
 
             len += CCM_IV_SIZE + CCM_COUNTER_SIZE + CCM_MIC_SIZE;
-            packetCounter++;
-            if (packetCounter > 200000) {
-                packetCounter = 0;
-            }
+            packetCounter = (packetCounter + 1) & CCM_COUNTER_MASK;
+            encrypted = true;
         }
     }
 #endif
 
-    //   for (int i = 0; i < retries; i++) {
-    arcCounter = 0;
     if (DPL) {
-        radioData[0] = len;
-        radioData[1] = PID;
+        slot->data[0] = len;
+        slot->data[1] = PID;
     }
     else {
-        radioData[1] = 0;
-        radioData[0] = PID;
+        slot->data[1] = 0;
+        slot->data[0] = PID;
     }
 
-    uint8_t dataStart = 0;
+    uint8_t dataStart = txDataStart(false);
+    NRF_STAGE_START(copyStart);
 
 #if defined CCM_ENCRYPTION_ENABLED
-
-    if (enableEncryption && doEncryption) {
-        dataStart = (!DPL && acksEnabled(0) == false) ? CCM_IV_SIZE + CCM_COUNTER_SIZE : CCM_IV_SIZE + CCM_COUNTER_SIZE + 2;
+    if (encrypted) {
+        dataStart += CCM_IV_SIZE + CCM_COUNTER_SIZE;
+        memcpy(&slot->data[dataStart - CCM_COUNTER_SIZE], &ccmData.counter, CCM_COUNTER_SIZE);
+        memcpy(&slot->data[dataStart - CCM_IV_SIZE - CCM_COUNTER_SIZE], ccmData.iv, CCM_IV_SIZE);
+        memcpy(&slot->data[dataStart], &outBuffer[CCM_START_SIZE], len - (CCM_IV_SIZE + CCM_COUNTER_SIZE));
+        slot->length = dataStart + len - (CCM_IV_SIZE + CCM_COUNTER_SIZE);
+#if defined NRF_RADIO_IRQ_ENABLED
+        NVIC_EnableIRQ(RADIO_IRQ_NUMBER);
+#endif
     }
     else {
 #endif
-        dataStart = (!DPL && acksEnabled(0) == false) ? 0 : 2;
+        if (buf != &slot->data[dataStart]) {
+            memcpy(&slot->data[dataStart], buf, len);
+        }
+        slot->length = dataStart + len;
 #if defined CCM_ENCRYPTION_ENABLED
     }
 #endif
 
+    NRF_STAGE_END(NRF_STAGE_COPY, copyStart);
+
+    slot->hopPhase = hopFrame;
+    if (slot->hopPhase) {
+        slot->data[0]++;
+        slot->data[slot->length++] = hopPhase();
+    }
+
+    slot->multicast = multicast;
+    slot->doEncryption = doEncryption;
+    return true;
+}
+
+/**********************************************************************************************************/
+
+uint16_t nrf_to_nrf::dataRateKbps()
+{
+    if (NRF_RADIO->MODE == (RADIO_MODE_MODE_Nrf_1Mbit << RADIO_MODE_MODE_Pos)) {
+        return 1000;
+    }
+    else if (NRF_RADIO->MODE == (RADIO_MODE_MODE_Nrf_250Kbit << RADIO_MODE_MODE_Pos)) {
+        return 250;
+    }
+#ifdef ARDUINO_NRF54L15
+    else if (NRF_RADIO->MODE != (RADIO_MODE_MODE_Nrf_2Mbit << RADIO_MODE_MODE_Pos)) {
+        return 4000;
+    }
+#endif
+    return 2000;
+}
+
+/**********************************************************************************************************/
+
+uint32_t nrf_to_nrf::ackWaitTime()
+{
+    // The ACK uses the current packet format, wait until its address should have been received
+    uint8_t addressWidth = ((NRF_RADIO->PCNF1 >> RADIO_PCNF1_BALEN_Pos) & 0x7) + 1;
+    uint32_t addressTime = nrf_airtime_us(dataRateKbps(), addressWidth, 0, 0, 0);
+
+    // Once the address is in, allow for the rest of the longest ACK the radio accepts
+    uint16_t maxLength = (NRF_RADIO->PCNF1 >> RADIO_PCNF1_MAXLEN_Pos) & 0xFF;
+    txAckFrameTime = frameAirtime(maxLength) - addressTime + NRF_ACK_TIMEOUT_MARGIN;
+
+#ifndef ARDUINO_NRF54L15
+    uint32_t rampUp = (NRF_RADIO->MODECNF0 & 1) ? RAMP_UP_FAST_US : RAMP_UP_DEFAULT_US;
+#else
+    uint32_t rampUp = (NRF_RADIO->TIMING & 1) ? RAMP_UP_FAST_US : RAMP_UP_DEFAULT_US;
+#endif
+
+#if defined NRF_ACK_KNOWN_PEERS
+    #if defined NRF_HW_ACK_TIMING
+    if (txHwAck) {
+        // Timed from the END of our packet, the receiver's ACK timer starts the ACK interframeSpacing later
+        return interframeSpacing + addressTime + NRF_ACK_TIMEOUT_MARGIN;
+    }
+    #endif
+    // Timed from when we are listening, the receiver turns around in software & ramps up to TX
+    return NRF_ACK_SW_TURNAROUND + rampUp + addressTime + NRF_ACK_TIMEOUT_MARGIN;
+#else
+    // The receiver may answer from available() & ramp up to TX with the default ramp-up time
+    uint32_t turnaround = DPL ? NRF_ACK_PEER_TURNAROUND : NRF_ACK_PEER_TURNAROUND_STATIC;
+    uint32_t timeout = turnaround + RAMP_UP_DEFAULT_US + addressTime + NRF_ACK_TIMEOUT_MARGIN;
+    #if defined NRF_HW_ACK_TIMING
+    if (txHwAck) {
+        // Timed from the END of our packet, we are only listening once ramped up again
+        timeout += rampUp;
+    }
+    #endif
+    return timeout;
+#endif
+}
+
+/**********************************************************************************************************/
+
+uint32_t nrf_to_nrf::frameAirtime(uint16_t length)
+{
+    // Time on air of a packet with the current packet format, length is the S0/LENGTH/S1 fields' payload size
+    uint8_t addressWidth = ((NRF_RADIO->PCNF1 >> RADIO_PCNF1_BALEN_Pos) & 0x7) + 1;
+    uint8_t headerBits = ((NRF_RADIO->PCNF0 >> RADIO_PCNF0_S0LEN_Pos) & 0x1) * 8;
+    headerBits += (NRF_RADIO->PCNF0 >> RADIO_PCNF0_LFLEN_Pos) & 0xF;
+    headerBits += (NRF_RADIO->PCNF0 >> RADIO_PCNF0_S1LEN_Pos) & 0xF;
+    return nrf_airtime_us(dataRateKbps(), addressWidth, headerBits, length, NRF_RADIO->CRCCNF & 0x3);
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::txStartAttempt()
+{
+    clockReady();
+    arcCounter = txAttempt;
+    NRF_TX_STAGE_START();
+    txFifoSlot_t* slot = txSendingAck ? &ackFrame : &txFifo[txFifoHead];
+    // Transmit straight from the TX FIFO slot, retries just re-trigger START on the same frame
+    NRF_RADIO->PACKETPTR = (uint32_t)slot->data;
+    if (slot->hopPhase) {
+        hopRetuneTx(slot);
+    }
+
+    // Queued payloads are started back-to-back, so the radio may still be ramping up to TXIDLE
+    txStage = TX_STAGE_RAMP_UP;
+    NRF_RADIO->EVENTS_READY = 0;
+    NRF_TX_WAIT(RADIO_IRQ_READY);
+    if (NRF_RADIO->STATE == RADIO_STATE_STATE_TxIdle) {
+        txStartFrame();
+        return;
+    }
+    txTimer = millis();
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::txStartFrame()
+{
+    // Called once the radio is in TXIDLE, and again once it is DISABLED for listen-before-talk
+    txFifoSlot_t* slot = txSendingAck ? &ackFrame : &txFifo[txFifoHead];
+#ifndef ARDUINO_NRF54L15
+    // The ACK can start sooner after END than the default RX ramp-up takes
+    NRF_RADIO->MODECNF0 |= 1;
+#endif
+#ifdef NRF_HAS_ENERGY_DETECT
+    // ACKs go out in the receiver's turnaround slot, without CCA
+    bool lbt = ccaThreshold && !txSendingAck;
+    if (lbt && txStage == TX_STAGE_RAMP_UP) {
+        // Listen-before-talk starts from DISABLED, the shorts below then run RXEN -> CCA -> TXEN -> START
+        txShorts = NRF_RADIO->SHORTS;
+        NRF_RADIO->SHORTS = 0;
+        NRF_RADIO->EVENTS_DISABLED = 0;
+        txTimer = millis();
+        txStage = TX_STAGE_CCA_DISABLE;
+        NRF_TX_WAIT(RADIO_IRQ_DISABLED);
+        NRF_RADIO->TASKS_DISABLE = 1;
+        return;
+    }
+    if (lbt) {
+        NRF_RADIO->SHORTS = txShorts;
+    }
+#endif
+#if defined NRF_HW_ACK_TIMING
+    // With DPL the ACK uses the same packet format, so the radio can turn around to RX by itself
+    txHwAck = DPL && !slot->multicast && acksPerPipe[NRF_RADIO->TXADDRESS];
+    if (txHwAck) {
+        txRxAddresses = NRF_RADIO->RXADDRESSES;
+        NRF_RADIO->RXADDRESSES = 1 << NRF_RADIO->TXADDRESS;
+        NRF_RADIO->EVENTS_CRCOK = 0;
+        NRF_RADIO->EVENTS_CRCERROR = 0;
+        NRF_RADIO->SHORTS = RADIO_SHORTS_READY_START_Msk | RADIO_SHORTS_END_DISABLE_Msk | RX_RSSI_SHORTS;
+        armAckTimer(ackWaitTime());
+    }
+#endif
+    NRF_RADIO->EVENTS_END = 0;
+    NRF_RADIO->EVENTS_ADDRESS = 0;
+#ifdef NRF_HAS_ENERGY_DETECT
+    if (lbt) {
+        if (slot->hopPhase) {
+            // The frame starts after the RX ramp-up, the CCA & the TX ramp-up
+            slot->data[slot->length - 1] = hopPhase(2 * RAMP_UP_FAST_US + CCA_US);
+        }
+        // Back to the usual TX shorts as soon as the frame is on air. Until then only the CCA chain may run: READY_START
+        // would start RX instead of the CCA, DISABLED_TXEN would send the frame anyway after CCABUSY_DISABLE
+        txShorts = NRF_RADIO->SHORTS;
+        uint32_t turnaround = RADIO_SHORTS_READY_START_Msk | RADIO_SHORTS_END_DISABLE_Msk | RADIO_SHORTS_DISABLED_TXEN_Msk | RADIO_SHORTS_DISABLED_RXEN_Msk;
+        NRF_RADIO->CCACTRL = (RADIO_CCACTRL_CCAMODE_EdMode << RADIO_CCACTRL_CCAMODE_Pos) | ((uint32_t)ccaThreshold << RADIO_CCACTRL_CCAEDTHRES_Pos);
+        NRF_RADIO->EVENTS_CCABUSY = 0;
+        NRF_RADIO->SHORTS = RADIO_SHORTS_RXREADY_CCASTART_Msk | RADIO_SHORTS_CCAIDLE_TXEN_Msk | RADIO_SHORTS_CCABUSY_DISABLE_Msk |
+                            RADIO_SHORTS_TXREADY_START_Msk | (txShorts & ~turnaround);
+        txStage = TX_STAGE_CCA;
+        NRF_TX_WAIT(RADIO_IRQ_ADDRESS | RADIO_IRQ_CCA_MASK);
+        NRF_RADIO->TASKS_RXEN = 1;
+        txTimer = millis();
+        return;
+    }
+#endif
+    if (slot->hopPhase) {
+        slot->data[slot->length - 1] = hopPhase();
+    }
+    NRF_RADIO->TASKS_START = 1;
+    txTimer = millis();
+#if defined NRF_HW_ACK_TIMING
+    if (txHwAck) {
+        txStage = TX_STAGE_STARTING;
+        NRF_TX_WAIT(RADIO_IRQ_ADDRESS);
+        return;
+    }
+#endif
+    txStage = TX_STAGE_SENDING;
+    NRF_TX_WAIT(RADIO_IRQ_END);
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::txStarted()
+{
+    // The frame's ADDRESS is on air
+#if defined NRF_HW_ACK_TIMING
+    if (txHwAck) {
+        // PACKETPTR is latched at START, so the ACK can now be received into radioData. Only then may the one-shot
+        // DISABLED -> RXEN channel turn the radio around, an ACK must never land in the TX slot.
+        NRF_RADIO->PACKETPTR = (uint32_t)radioData;
+        NRF_PPI->CHENSET = 1 << (NRF_ACK_PPI_CH + 1);
+        if (NRF_RADIO->STATE == RADIO_STATE_STATE_Disabled) {
+            NRF_PPI->CHENCLR = 1 << (NRF_ACK_PPI_CH + 1);
+            NRF_RADIO->TASKS_RXEN = 1;
+        }
+    }
+#endif
+    txStage = TX_STAGE_SENDING;
+    NRF_TX_WAIT(RADIO_IRQ_END);
+}
+
+/**********************************************************************************************************/
+
+bool nrf_to_nrf::txChannelBusy()
+{
+    // CCABUSY_DISABLE leaves the chain shorts set, clear them before anything else starts the radio
+    NRF_RADIO->SHORTS = 0;
+    NRF_TX_STAGE_END(NRF_STAGE_TX);
+    linkStats[NRF_RADIO->TXADDRESS].txCcaBusy++;
+#if defined NRF_HW_ACK_TIMING
+    if (txHwAck) {
+        // The ACK timer was armed for the frame
+        disarmAckTimer();
+        NRF_RADIO->RXADDRESSES = txRxAddresses;
+    }
+#endif
+    // Back to TX idle, nothing else was changed so the retry delay restores the current settings
+    stopListening(false, false);
+    txRxAddresses = NRF_RADIO->RXADDRESSES;
+    if (!DPL) {
+        txPayloadSize = getPayloadSize();
+    }
+    if (txAttempt >= retries) {
+        return 0;
+    }
+    txRetryDelay();
+    return 1;
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::txRetryDelay()
+{
+    uint32_t delay = 258UL * retryDuration;
+    if (backoffPolicy != NRF_BACKOFF_FIXED && delay) {
+        // The window doubles with each retry up to the cap, the random policy always uses twice the fixed delay
+        uint8_t shift = backoffPolicy == NRF_BACKOFF_RANDOM ? 1 : min((uint8_t)(txAttempt + 1), backoffCap);
+        delay = backoffRandom() % ((delay << shift) + 1);
+    }
+    txBackoff = delay;
+    txBackedOff = true;
+    backoffStats[backoffPolicy].backoffs++;
+    backoffStats[backoffPolicy].backoffTime += delay;
+    txTimer = micros();
+    txStage = TX_STAGE_RETRY_DELAY;
+    NRF_TX_WAIT(0);
+    NRF_TX_STAGE_START();
+}
+
+/**********************************************************************************************************/
+
+uint32_t nrf_to_nrf::backoffRandom()
+{
+    backoffState ^= backoffState << 13;
+    backoffState ^= backoffState >> 17;
+    backoffState ^= backoffState << 5;
+    return backoffState;
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::txComplete(bool success)
+{
+    txStage = TX_STAGE_IDLE;
+    NRF_TX_WAIT(0);
+    lastTxResult = success;
+
+    if (!success && txReuse) {
+        // txStandBy(timeout) keeps re-sending a failed payload until it times out, like the nRF24 REUSE_TX_PL
+        txAttempt = 0;
+        linkStats[NRF_RADIO->TXADDRESS].txRetransmits++;
+        txStartAttempt();
+        return;
+    }
+    if (!success) {
+        txFifoFailed = true;
+    }
+    if (!txSendingAck) {
+        if (success) {
+            linkStats[NRF_RADIO->TXADDRESS].txPackets++;
+        }
+        else {
+            linkStats[NRF_RADIO->TXADDRESS].txFailures++;
+        }
+        if (txBackedOff) {
+            if (success) {
+                backoffStats[backoffPolicy].recovered++;
+            }
+            else {
+                backoffStats[backoffPolicy].failed++;
+            }
+        }
+    }
+    txBackedOff = false;
+    if (!txSendingAck) {
+        txFifoHead = (txFifoHead + 1) % NRF_TX_FIFO_SIZE;
+        txFifoCount--;
+    }
+
+    if (txCallback != NULL) {
+        txCallback(success, arcCounter);
+    }
+
+    // Send the next queued payload straight away
+    if (txFifoCount && txStage == TX_STAGE_IDLE) {
+        txAttempt = 0;
+        txStartAttempt();
+    }
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::txRestoreRx()
+{
+    stopListening(false, false);
+    if (!DPL) {
+        setPayloadSize(txPayloadSize);
+    }
+    NRF_RADIO->RXADDRESSES = txRxAddresses;
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::updateTx()
+{
+#if defined NRF_RADIO_IRQ_ENABLED
+    // The RADIO interrupt also advances the stages, see handleRadioIRQ()
+    NVIC_DisableIRQ(RADIO_IRQ_NUMBER);
+    advanceTx();
+    NVIC_EnableIRQ(RADIO_IRQ_NUMBER);
+#else
+    advanceTx();
+#endif
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::advanceTx()
+{
+    if (txStage == TX_STAGE_RAMP_UP) {
+        if (NRF_RADIO->STATE == RADIO_STATE_STATE_TxIdle) {
+            txStartFrame();
+        }
+        else if (millis() - txTimer > 250) {
+            txComplete(false);
+        }
+        return;
+    }
+
+#ifdef NRF_HAS_ENERGY_DETECT
+    if (txStage == TX_STAGE_CCA_DISABLE) {
+        if (NRF_RADIO->EVENTS_DISABLED) {
+            NRF_RADIO->EVENTS_DISABLED = 0;
+            txStartFrame();
+        }
+        else if (millis() - txTimer > DEFAULT_TIMEOUT) {
+            txComplete(false);
+        }
+        return;
+    }
+
+    if (txStage == TX_STAGE_CCA) {
+        if (NRF_RADIO->EVENTS_CCABUSY) {
+            if (!txChannelBusy()) {
+                txComplete(false);
+            }
+        }
+        else if (NRF_RADIO->EVENTS_ADDRESS) {
+            NRF_RADIO->SHORTS = txShorts;
+            if (NRF_RADIO->EVENTS_END && (txShorts & RADIO_SHORTS_END_DISABLE_Msk)) {
+                // A short frame ended before the shorts were back, disable as END_DISABLE would have
+                NRF_RADIO->TASKS_DISABLE = 1;
+            }
+            txStarted();
+        }
+        else if (millis() - txTimer > DEFAULT_TIMEOUT) {
+            txComplete(false);
+        }
+        return;
+    }
+#endif
+
+#if defined NRF_HW_ACK_TIMING
+    if (txStage == TX_STAGE_STARTING) {
+        if (!NRF_RADIO->EVENTS_ADDRESS) {
+            if (millis() - txTimer > DEFAULT_TIMEOUT) {
+                txComplete(false);
+            }
+            return;
+        }
+        txStarted();
+    }
+#endif
+
+    if (txStage == TX_STAGE_SENDING_NO_ACK) {
+        // startWrite() doesn't wait for an ACK, the frame is done once it has been sent
+        if (NRF_RADIO->EVENTS_END) {
+            NRF_RADIO->EVENTS_END = 0;
+            txComplete(true);
+        }
+        else if (millis() - txTimer > DEFAULT_TIMEOUT) {
+            txComplete(false);
+        }
+        return;
+    }
+
+    if (txStage == TX_STAGE_SENDING) {
+        if (!NRF_RADIO->EVENTS_END) {
+            if (millis() - txTimer > DEFAULT_TIMEOUT) {
+                txComplete(false);
+            }
+            return;
+        }
+
+        NRF_RADIO->EVENTS_END = 0;
+        NRF_TX_STAGE_END(NRF_STAGE_TX);
+        NRF_TX_STAGE_START();
+#if defined NRF_HW_ACK_TIMING
+        if (txHwAck) {
+            // The radio is already ramping up to RX, the ACK timeout is enforced by NRF_ACK_TIMER. Its compare
+            // disables the radio, so DISABLED wakes the interrupt for the timeout.
+            txStage = TX_STAGE_WAIT_ACK;
+            NRF_TX_WAIT(RADIO_IRQ_RX_MASK | RADIO_IRQ_DISABLED);
+            txTimer = millis();
+            return;
+        }
+#endif
+        if (!txSendingAck && !txFifo[txFifoHead].multicast && acksPerPipe[NRF_RADIO->TXADDRESS] == true) {
+            NRF_RADIO->PACKETPTR = (uint32_t)radioData;
+            txRxAddresses = NRF_RADIO->RXADDRESSES;
+            NRF_RADIO->RXADDRESSES = 1 << NRF_RADIO->TXADDRESS;
+            if (!DPL) {
+                txPayloadSize = getPayloadSize();
+                setPayloadSize(0);
+            }
+            txStage = TX_STAGE_WAIT_ACK;
+            NRF_RADIO->EVENTS_ADDRESS = 0;
+            startListening(false);
+            NRF_TX_WAIT(RADIO_IRQ_RX_MASK);
+            NRF_TX_STAGE_START();
+
+            txAckTimeout = ackWaitTime();
+            txTimer = micros();
+        }
+        else {
+            txComplete(true);
+        }
+        return;
+    }
+
+    if (txStage == TX_STAGE_WAIT_ACK) {
+#if defined NRF_HW_ACK_TIMING
+        if (txHwAck) {
+    #if defined NRF_RADIO_IRQ_ENABLED
+            // The radio also disables itself after our END & after the ACK, COMPARE[0] tells the timeout apart
+            NRF_RADIO->EVENTS_DISABLED = 0;
+    #endif
+            if (!NRF_RADIO->EVENTS_CRCOK && !NRF_RADIO->EVENTS_CRCERROR && !NRF_ACK_TIMER->EVENTS_COMPARE[0]) {
+                if (millis() - txTimer <= DEFAULT_TIMEOUT) {
+                    return;
+                }
+            }
+            disarmAckTimer();
+        }
+#endif
+        if (NRF_RADIO->EVENTS_CRCOK) {
+            NRF_TX_STAGE_END(NRF_STAGE_ACK_WAIT);
+            if (ackPayloadsEnabled && radioData[0] > 0 && rxFifoCount >= NRF_RX_FIFO_SIZE) {
+                linkStats[NRF_RADIO->TXADDRESS].rxFifoFull++;
+            }
+            else if (ackPayloadsEnabled && radioData[0] > 0) {
+                rxFifoSlot_t* slot = &rxFifo[rxFifoTail];
 #if defined CCM_ENCRYPTION_ENABLED
-    if (enableEncryption && doEncryption) {
-        memcpy(&radioData[dataStart - CCM_COUNTER_SIZE], &tmpCounter, CCM_COUNTER_SIZE);
-        memcpy(&radioData[dataStart - CCM_IV_SIZE - CCM_COUNTER_SIZE], &tmpIV[0], CCM_IV_SIZE);
-        memcpy(&radioData[dataStart], &outBuffer[CCM_START_SIZE], len - (CCM_IV_SIZE + CCM_COUNTER_SIZE));
+                if (enableEncryption && txFifo[txFifoHead].doEncryption) {
+                    memcpy(slot->frame, &radioData[2 + CCM_COUNTER_SIZE + CCM_IV_SIZE], max(0, radioData[0] - CCM_COUNTER_SIZE - CCM_IV_SIZE));
+                }
+                else {
+                    memcpy(slot->frame, &radioData[2], radioData[0]);
+                }
+#else
+                memcpy(slot->frame, &radioData[2], radioData[0]);
+#endif
+
+#if defined CCM_ENCRYPTION_ENABLED
+                if (enableEncryption && radioData[0] > 0) {
+                    memcpy(ccmData.iv, &radioData[2], CCM_IV_SIZE);
+                    memcpy(&ccmData.counter, &radioData[2 + CCM_IV_SIZE], CCM_COUNTER_SIZE);
+
+                    if (!decrypt(slot->frame, radioData[0] - CCM_IV_SIZE - CCM_COUNTER_SIZE)) {
+                        linkStats[NRF_RADIO->TXADDRESS].rxDecryptFailures++;
+                        NRF_RADIO->EVENTS_CRCOK = 0;
+                        txRestoreRx();
+                        txComplete(false);
+                        return;
+                    }
+                    if (radioData[0] >= CCM_MIC_SIZE + CCM_COUNTER_SIZE + CCM_IV_SIZE) {
+                        radioData[0] -= CCM_MIC_SIZE + CCM_COUNTER_SIZE + CCM_IV_SIZE;
+                    }
+                    memcpy(slot->frame, &outBuffer[CCM_START_SIZE], radioData[0]);
+                }
+#endif
+                slot->length = radioData[0];
+                slot->offset = 0;
+                slot->pipe = NRF_RADIO->RXMATCH;
+#ifndef ARDUINO_NRF54L15
+                slot->rssi = (uint8_t)NRF_RADIO->RSSISAMPLE;
+#else
+                slot->rssi = 0;
+#endif
+                rxFifoTail = (rxFifoTail + 1) % NRF_RX_FIFO_SIZE;
+                rxFifoCount++;
+                linkStats[NRF_RADIO->TXADDRESS].rxPackets++;
+            }
+            NRF_RADIO->EVENTS_CRCOK = 0;
+            // The receiver is on our channel, so the hop clocks are still in sync
+            hopIdleSlots = 0;
+            txRestoreRx();
+            txComplete(true);
+            return;
+        }
+        if (NRF_RADIO->EVENTS_CRCERROR) {
+            NRF_RADIO->EVENTS_CRCERROR = 0;
+            linkStats[NRF_RADIO->TXADDRESS].rxCrcErrors++;
+        }
+#if defined NRF_HW_ACK_TIMING
+        else if (!txHwAck && micros() - txTimer <= txAckTimeout + (NRF_RADIO->EVENTS_ADDRESS ? txAckFrameTime : 0)) {
+#else
+        else if (micros() - txTimer <= txAckTimeout + (NRF_RADIO->EVENTS_ADDRESS ? txAckFrameTime : 0)) {
+#endif
+            // Still waiting for the ACK, or for the end of one that is being received
+            return;
+        }
+        else {
+            linkStats[NRF_RADIO->TXADDRESS].txAckTimeouts++;
+        }
+        NRF_TX_STAGE_END(NRF_STAGE_ACK_WAIT);
+
+        // No ACK received, wait before the next attempt
+        if (txAttempt >= retries) {
+            txRestoreRx();
+            txComplete(false);
+            return;
+        }
+        txRetryDelay();
+        return;
+    }
+
+    if (txStage == TX_STAGE_RETRY_DELAY) {
+        if (micros() - txTimer < txBackoff) {
+            return;
+        }
+        NRF_TX_STAGE_END(NRF_STAGE_RETRY_DELAY);
+        txRestoreRx();
+        txAttempt++;
+        linkStats[NRF_RADIO->TXADDRESS].txRetransmits++;
+        txStartAttempt();
+    }
+}
+
+/**********************************************************************************************************/
+
+bool nrf_to_nrf::write(void* buf, uint8_t len, bool multicast, bool doEncryption)
+{
+
+    NRF_STAGE_START(writeStart);
+    while (txFifoCount >= NRF_TX_FIFO_SIZE) {
+        updateTx();
+    }
+    // Failures of payloads queued earlier by writeFast() are left for txStandBy() to report, this payload's result
+    // is only returned here
+    bool fifoFailed = txFifoFailed;
+    if (!writeAsync(buf, len, multicast, doEncryption)) {
+        txFifoFailed = fifoFailed;
+        NRF_STAGE_END(NRF_STAGE_WRITE, writeStart);
+        return 0;
+    }
+    while (txFifoCount > 1) {
+        updateTx();
+    }
+    fifoFailed = txFifoFailed;
+    while (txStage != TX_STAGE_IDLE) {
+        updateTx();
+    }
+    txFifoFailed = fifoFailed;
+    NRF_STAGE_END(NRF_STAGE_WRITE, writeStart);
+    return lastTxResult;
+}
+
+/**********************************************************************************************************/
+
+bool nrf_to_nrf::writeAsync(void* buf, uint8_t len, bool multicast, bool doEncryption)
+{
+
+    if (txSendingAck) {
+        // Sent from the RX path, which may have interrupted a sketch filling the getTxBuffer() slot
+        prepareTx(&ackFrame, buf, len, multicast, doEncryption);
     }
     else {
+        if (txFifoCount >= NRF_TX_FIFO_SIZE) {
+            return 0;
+        }
+        if (!prepareTx(&txFifo[txFifoTail], buf, len, multicast, doEncryption)) {
+            lastTxResult = false;
+            return 0;
+        }
+    }
+
+#if defined NRF_RADIO_IRQ_ENABLED
+    // The RADIO interrupt moves the head of the FIFO on
+    NVIC_DisableIRQ(RADIO_IRQ_NUMBER);
 #endif
-        memcpy(&radioData[dataStart], buf, len);
+    if (!txSendingAck) {
+        txFifoTail = (txFifoTail + 1) % NRF_TX_FIFO_SIZE;
+        txFifoCount++;
+    }
+    if (txStage == TX_STAGE_IDLE) {
+        txAttempt = 0;
+        txStartAttempt();
+    }
+#if defined NRF_RADIO_IRQ_ENABLED
+    NVIC_EnableIRQ(RADIO_IRQ_NUMBER);
+#endif
+    return 1;
+}
+
+/**********************************************************************************************************/
+
+uint8_t nrf_to_nrf::txDataStart(bool doEncryption)
+{
+    uint8_t dataStart = (!DPL && acksEnabled(0) == false) ? 0 : 2;
 #if defined CCM_ENCRYPTION_ENABLED
+    if (enableEncryption && doEncryption) {
+        dataStart += CCM_IV_SIZE + CCM_COUNTER_SIZE;
     }
 #endif
+    return dataStart;
+}
+
+/**********************************************************************************************************/
+
+uint8_t* nrf_to_nrf::getTxBuffer(bool doEncryption)
+{
+
+    if (txFifoCount >= NRF_TX_FIFO_SIZE) {
+        return NULL;
+    }
+    return &txFifo[txFifoTail].data[txDataStart(doEncryption)];
+}
+
+/**********************************************************************************************************/
+
+bool nrf_to_nrf::writeTxBuffer(uint8_t len, bool multicast, bool doEncryption)
+{
+
+    if (txFifoCount >= NRF_TX_FIFO_SIZE) {
+        return 0;
+    }
+    return write(&txFifo[txFifoTail].data[txDataStart(doEncryption)], len, multicast, doEncryption);
+}
+
+/**********************************************************************************************************/
+
+nrf_tx_status_e nrf_to_nrf::txStatus()
+{
+
+    if (txStage != TX_STAGE_IDLE) {
+        updateTx();
+        if (txStage != TX_STAGE_IDLE) {
+            return NRF_TX_BUSY;
+        }
+    }
+    return lastTxResult ? NRF_TX_SUCCESS : NRF_TX_FAILED;
+}
+
+/**********************************************************************************************************/
+
+bool nrf_to_nrf::startWrite(void* buf, uint8_t len, bool multicast, bool doEncryption)
+{
+
+    // Sent straight away from a TX FIFO slot, so nothing else may be using the FIFO
+    if (txStage != TX_STAGE_IDLE || txFifoCount >= NRF_TX_FIFO_SIZE) {
+        return 0;
+    }
+    txFifoSlot_t* slot = &txFifo[txFifoTail];
+    if (!prepareTx(slot, buf, len, multicast, doEncryption)) {
+        return 0;
+    }
+    // The slot stays claimed until END, so payloads queued meanwhile can't overwrite the frame on air
+    txFifoTail = (txFifoTail + 1) % NRF_TX_FIFO_SIZE;
+    txFifoCount++;
+
+    txAttempt = 0;
+    arcCounter = 0;
+    txSendingAck = false;
+#if defined NRF_HW_ACK_TIMING
+    txHwAck = false;
+#endif
+    NRF_RADIO->PACKETPTR = (uint32_t)slot->data;
 
     NRF_RADIO->EVENTS_END = 0;
     NRF_RADIO->TASKS_START = 1;
     lastTxResult = true;
+    txTimer = millis();
+    txStage = TX_STAGE_SENDING_NO_ACK;
+    NRF_TX_WAIT(RADIO_IRQ_END);
 
     return true;
 }
@@ -675,46 +1891,130 @@ bool nrf_to_nrf::startWrite(void* buf, uint8_t len, bool multicast, bool doEncry
 bool nrf_to_nrf::writeAckPayload(uint8_t pipe, void* buf, uint8_t len)
 {
 
+    if (ackCount >= NRF_ACK_FIFO_SIZE) {
+        return false;
+    }
+    uint8_t index = 0;
+    while (ackSlots[index].pipe != ACK_SLOT_FREE) {
+        index++;
+    }
+    ackSlot_t* slot = &ackSlots[index];
+
 #if defined CCM_ENCRYPTION_ENABLED
     if (enableEncryption) {
         if (len) {
 
-            for (int i = 0; i < CCM_IV_SIZE; i++) {
-                if (!waitForEvent(&NRF_RNG->EVENTS_VALRDY, 100))
-                    return 0;
-                NRF_RNG->EVENTS_VALRDY = 0;
-                ccmData.iv[i] = NRF_RNG->VALUE;
-                ackBuffer[i + 1] = ccmData.iv[i];
+            if (!takeIV(slot->data)) {
+                return 0;
             }
 
+            // Called while listening, the RX interrupt would use the same CCM, IV, counter & output buffer
+#if defined NRF_RADIO_IRQ_ENABLED
+            NVIC_DisableIRQ(RADIO_IRQ_NUMBER);
+#endif
+            memcpy(ccmData.iv, slot->data, CCM_IV_SIZE);
             ccmData.counter = packetCounter;
-            memcpy(&ackBuffer[1 + CCM_IV_SIZE], &ccmData.counter, CCM_COUNTER_SIZE);
+            memcpy(&slot->data[CCM_IV_SIZE], &ccmData.counter, CCM_COUNTER_SIZE);
 
-            if (!encrypt(buf, len)) {
-                return 0;
+            bool encrypted = encrypt(buf, len);
+            if (encrypted) {
+                len += CCM_IV_SIZE + CCM_COUNTER_SIZE + CCM_MIC_SIZE;
+                memcpy(&slot->data[CCM_IV_SIZE + CCM_COUNTER_SIZE], &outBuffer[CCM_START_SIZE], len - CCM_IV_SIZE - CCM_COUNTER_SIZE);
+                packetCounter = (packetCounter + 1) & CCM_COUNTER_MASK;
             }
-
-            len += CCM_IV_SIZE + CCM_COUNTER_SIZE + CCM_MIC_SIZE;
-            memcpy(&ackBuffer[1 + CCM_IV_SIZE + CCM_COUNTER_SIZE], &outBuffer[CCM_START_SIZE], len - CCM_IV_SIZE - CCM_COUNTER_SIZE);
-            packetCounter++;
-            if (packetCounter > 200000) {
-                packetCounter = 0;
+#if defined NRF_RADIO_IRQ_ENABLED
+            NVIC_EnableIRQ(RADIO_IRQ_NUMBER);
+#endif
+            if (!encrypted) {
+                return 0;
             }
         }
     }
     else {
 #endif
-        memcpy(&ackBuffer[1], buf, len);
+        memcpy(slot->data, buf, len);
 #if defined CCM_ENCRYPTION_ENABLED
     }
 #endif
-    ackBuffer[0] = len;
-    ackPipe = pipe;
+    slot->length = len;
+
+    // The slot only becomes visible to the RX path once it is complete
+#if defined NRF_RADIO_IRQ_ENABLED
+    NVIC_DisableIRQ(RADIO_IRQ_NUMBER);
+#endif
+    slot->pipe = pipe;
+    ackOrder[ackCount++] = index;
+#if defined NRF_RADIO_IRQ_ENABLED
+    NVIC_EnableIRQ(RADIO_IRQ_NUMBER);
+#endif
+#if defined NRF_HW_ACK_TIMING
+    restageHwAck();
+#endif
     return true;
 }
 
 /**********************************************************************************************************/
 
+uint8_t nrf_to_nrf::getAckPayloadCount(uint8_t pipe)
+{
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < NRF_ACK_FIFO_SIZE; i++) {
+        if (ackSlots[i].pipe == pipe) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/**********************************************************************************************************/
+
+nrf_to_nrf::ackSlot_t* nrf_to_nrf::nextAckPayload(uint8_t pipe, bool retransmit)
+{
+    uint8_t mask = 1 << pipe;
+    uint8_t i = 0;
+    while (i < ackCount) {
+        ackSlot_t* slot = &ackSlots[ackOrder[i]];
+        if (slot->pipe != pipe) {
+            i++;
+            continue;
+        }
+        if ((ackSentPipes & mask) && !retransmit) {
+            // A new packet on this pipe, so the payload sent with the previous ACK was delivered
+            slot->pipe = ACK_SLOT_FREE;
+            ackCount--;
+            memmove(&ackOrder[i], &ackOrder[i + 1], ackCount - i);
+            ackSentPipes &= ~mask;
+            continue;
+        }
+        ackSentPipes |= mask;
+        return slot;
+    }
+    ackSentPipes &= ~mask;
+    return NULL;
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::flushAckPayloads()
+{
+#if defined NRF_RADIO_IRQ_ENABLED
+    NVIC_DisableIRQ(RADIO_IRQ_NUMBER);
+#endif
+    for (uint8_t i = 0; i < NRF_ACK_FIFO_SIZE; i++) {
+        ackSlots[i].pipe = ACK_SLOT_FREE;
+    }
+    ackCount = 0;
+    ackSentPipes = 0;
+#if defined NRF_RADIO_IRQ_ENABLED
+    NVIC_EnableIRQ(RADIO_IRQ_NUMBER);
+#endif
+#if defined NRF_HW_ACK_TIMING
+    restageHwAck();
+#endif
+}
+
+/**********************************************************************************************************/
+
 void nrf_to_nrf::enableAckPayload() { ackPayloadsEnabled = true; }
 
 /**********************************************************************************************************/
@@ -725,6 +2025,21 @@ void nrf_to_nrf::disableAckPayload() { ackPayloadsEnabled = false; }
 
 void nrf_to_nrf::startListening(bool resetAddresses)
 {
+    NRF_STAGE_START(switchStart);
+    clockReady();
+    // Let a frame from startWrite() end instead of cutting it off
+    while (txStage == TX_STAGE_SENDING_NO_ACK) {
+        updateTx();
+    }
+#if defined NRF_RADIO_IRQ_ENABLED
+    NRF_RADIO->RADIO_INTENCLR = RADIO_IRQ_RX_MASK;
+#endif
+#if defined NRF_HW_ACK_TIMING
+    hwAckFinish();
+    disarmAckTimer();
+#endif
+    // Clear the TX shorts first, DISABLED_TXEN would otherwise ramp the radio back up to TX once disabled
+    NRF_RADIO->SHORTS = 0;
 
     NRF_RADIO->EVENTS_DISABLED = 0;
     NRF_RADIO->TASKS_DISABLE = 1;
@@ -744,7 +2059,23 @@ void nrf_to_nrf::startListening(bool resetAddresses)
         NRF_RADIO->TIFS = 0;
     }
     NRF_RADIO->SHORTS = 0x0;
+#if defined NRF_HW_ACK_TIMING
+    rxShorts = RX_RSSI_SHORTS;
+    if (DPL) {
+        for (uint8_t i = 0; i < 8; i++) {
+            if (acksPerPipe[i]) {
+                // Disable after every received packet, the ACK timer turns the radio around to TX from there
+                rxShorts |= RADIO_SHORTS_READY_START_Msk | RADIO_SHORTS_END_DISABLE_Msk;
+                NRF_RADIO->TIFS = interframeSpacing;
+                break;
+            }
+        }
+    }
+#endif
 
+    if (txStage == TX_STAGE_IDLE) {
+        rxArm();
+    }
     NRF_RADIO->EVENTS_RXREADY = 0;
     NRF_RADIO->EVENTS_CRCOK = 0;
     NRF_RADIO->TASKS_RXEN = 1;
@@ -752,13 +2083,47 @@ void nrf_to_nrf::startListening(bool resetAddresses)
         return;
 
     NRF_RADIO->TASKS_START = 1;
+#if defined NRF_HW_ACK_TIMING
+    NRF_RADIO->SHORTS = rxShorts;
+    if ((rxShorts & RADIO_SHORTS_END_DISABLE_Msk) && txStage == TX_STAGE_IDLE) {
+        armAckTurnaround();
+    }
+#else
+    NRF_RADIO->SHORTS = RX_RSSI_SHORTS;
+#endif
     inRxMode = true;
+#if defined NRF_RADIO_IRQ_ENABLED
+    if (txStage == TX_STAGE_IDLE) {
+        NRF_RADIO->RADIO_INTENSET = RADIO_IRQ_RX_MASK;
+    }
+#endif
+    NRF_STAGE_END(NRF_STAGE_MODE_SWITCH, switchStart);
 }
 
 /**********************************************************************************************************/
 
 void nrf_to_nrf::stopListening(bool setWritingPipe, bool resetAddresses)
 {
+    NRF_STAGE_START(switchStart);
+    clockReady();
+#if defined NRF_DUTY_CYCLE
+    if (setWritingPipe && dutyWindowTicks) {
+        dutyDisarm();
+    }
+#endif
+    if (setWritingPipe && ackPayloadsEnabled) {
+        // Switching to TX like the nRF24, internal ACK & TX turnarounds keep the payloads
+        flushAckPayloads();
+    }
+#if defined NRF_RADIO_IRQ_ENABLED
+    NRF_RADIO->RADIO_INTENCLR = RADIO_IRQ_RX_MASK;
+#endif
+#if defined NRF_HW_ACK_TIMING
+    // Don't let the RX shorts or the ACK turnaround start anything while ramping up
+    hwAckFinish();
+    NRF_RADIO->SHORTS = 0;
+    disarmAckTimer();
+#endif
     NRF_RADIO->EVENTS_DISABLED = 0;
     NRF_RADIO->TASKS_DISABLE = 1;
     if (!waitForEvent(&NRF_RADIO->EVENTS_DISABLED))
@@ -778,59 +2143,225 @@ void nrf_to_nrf::stopListening(bool setWritingPipe, bool resetAddresses)
         NRF_RADIO->TIMING = 0x0;
 #endif
     }
-#ifndef ARDUINO_NRF54L15
-    NRF_RADIO->SHORTS = 0x6;
-#else
-    NRF_RADIO->SHORTS = 0x80004;
+#ifndef ARDUINO_NRF54L15
+    NRF_RADIO->SHORTS = 0x6;
+#else
+    NRF_RADIO->SHORTS = 0x80004;
+#endif
+    if (NRF_RADIO->STATE < 9) {
+        NRF_RADIO->EVENTS_TXREADY = 0;
+        NRF_RADIO->TASKS_TXEN = 1;
+        if (!waitForEvent(&NRF_RADIO->EVENTS_TXREADY))
+            return;
+        NRF_RADIO->EVENTS_TXREADY = 0;
+    }
+
+    inRxMode = false;
+    NRF_STAGE_END(NRF_STAGE_MODE_SWITCH, switchStart);
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::stopListening(const uint8_t* txAddress, bool setWritingPipe, bool resetAddresses)
+{
+    stopListening(setWritingPipe, resetAddresses);
+    openWritingPipe(txAddress);
+}
+
+/**********************************************************************************************************/
+
+uint8_t nrf_to_nrf::getDynamicPayloadSize()
+{
+    if (!rxFifoCount) {
+        return 0;
+    }
+    uint8_t size = min(staticPayloadSize, rxFifo[rxFifoHead].length);
+    return size;
+}
+
+/**********************************************************************************************************/
+
+bool nrf_to_nrf::isValid()
+{
+
+    uint32_t freq = NRF_RADIO->FREQUENCY;
+    NRF_RADIO->FREQUENCY = 0x4C;
+    if (NRF_RADIO->FREQUENCY == 0x4C) {
+        NRF_RADIO->FREQUENCY = freq;
+        return 1;
+    }
+    return 0;
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::setChannel(uint8_t channel, bool map)
+{
+#if defined NRF_HW_ACK_TIMING
+    hwAckFinish();
+#endif
+    NRF_RADIO->FREQUENCY = channel | map << RADIO_FREQUENCY_MAP_Pos;
+}
+
+/**********************************************************************************************************/
+
+uint8_t nrf_to_nrf::getChannel() { return (uint8_t)NRF_RADIO->FREQUENCY; }
+
+/**********************************************************************************************************/
+
+bool nrf_to_nrf::enableHopping(const uint8_t* channels, uint8_t count, uint32_t seed, uint32_t dwellTime)
+{
+    if (!DPL || count == 0 || count > NRF_HOP_MAX_CHANNELS || dwellTime == 0) {
+        return false;
+    }
+#if defined NRF_RADIO_IRQ_ENABLED
+    NVIC_DisableIRQ(RADIO_IRQ_NUMBER);
 #endif
-    if (NRF_RADIO->STATE < 9) {
-        NRF_RADIO->EVENTS_TXREADY = 0;
-        NRF_RADIO->TASKS_TXEN = 1;
-        if (!waitForEvent(&NRF_RADIO->EVENTS_TXREADY))
-            return;
-        NRF_RADIO->EVENTS_TXREADY = 0;
-    }
+    // Fisher-Yates shuffle driven by xorshift32, every node with the same seed gets the same sequence
+    memcpy(hopChannels, channels, count);
+    uint32_t state = seed ? seed : 1;
+    for (uint8_t i = count - 1; i > 0; i--) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        uint8_t j = state % (i + 1);
+        uint8_t channel = hopChannels[i];
+        hopChannels[i] = hopChannels[j];
+        hopChannels[j] = channel;
+    }
+    hopCount = count;
+    hopDwell = dwellTime;
+    hopSlotStart = micros();
+    hopIndex = 0;
+    hopTunedIndex = HOP_NOT_TUNED;
+    // Not in sync with anyone yet, listen on the first channel until another node is heard
+    hopParked = true;
+    hopParkIndex = 0;
+    hopIdleSlots = 0;
+#if defined NRF_RADIO_IRQ_ENABLED
+    NVIC_EnableIRQ(RADIO_IRQ_NUMBER);
+#endif
+    return true;
+}
 
-    inRxMode = false;
+/**********************************************************************************************************/
+
+void nrf_to_nrf::disableHopping() { hopCount = 0; }
+
+/**********************************************************************************************************/
+
+bool nrf_to_nrf::isHopSynchronized()
+{
+    if (!hopCount) {
+        return false;
+    }
+    hopUpdate();
+    return !hopParked;
 }
 
 /**********************************************************************************************************/
 
-void nrf_to_nrf::stopListening(const uint8_t* txAddress, bool setWritingPipe, bool resetAddresses)
+void nrf_to_nrf::hopUpdate()
 {
-    stopListening(setWritingPipe, resetAddresses);
-    openWritingPipe(txAddress);
+#if defined NRF_RADIO_IRQ_ENABLED
+    // hopSync() moves the clock from the interrupt
+    NVIC_DisableIRQ(RADIO_IRQ_NUMBER);
+#endif
+    uint32_t elapsed = micros() - hopSlotStart;
+    if (elapsed >= hopDwell) {
+        uint32_t slots = elapsed / hopDwell;
+        hopSlotStart += slots * hopDwell;
+        hopIndex = (hopIndex + slots % hopCount) % hopCount;
+        hopIdleSlots += slots;
+        if (!hopParked && hopIdleSlots >= (uint32_t)hopCount * NRF_HOP_RESYNC_CYCLES) {
+            // Lost the other nodes, wait for them on one channel, they visit it once per cycle
+            hopParked = true;
+            hopParkIndex = hopIndex;
+        }
+    }
+#if defined NRF_RADIO_IRQ_ENABLED
+    NVIC_EnableIRQ(RADIO_IRQ_NUMBER);
+#endif
 }
 
 /**********************************************************************************************************/
 
-uint8_t nrf_to_nrf::getDynamicPayloadSize()
+void nrf_to_nrf::hopListen()
 {
-    uint8_t size = min(staticPayloadSize, rxBuffer[0]);
-    return size;
+    hopUpdate();
+    uint8_t index = hopParked ? hopParkIndex : hopIndex;
+    if (!inRxMode || index == hopTunedIndex) {
+        return;
+    }
+#if defined NRF_RADIO_IRQ_ENABLED
+    NVIC_DisableIRQ(RADIO_IRQ_NUMBER);
+#endif
+    // Not while a received packet is being handled, its ACK goes out on the current channel
+    bool busy = rxBusy;
+#if defined NRF_HW_ACK_TIMING
+    busy |= rxTurn != RX_TURN_NONE;
+#endif
+    if (!busy) {
+        NRF_RADIO->FREQUENCY = hopChannels[index];
+        hopTunedIndex = index;
+        startListening(false);
+    }
+#if defined NRF_RADIO_IRQ_ENABLED
+    NVIC_EnableIRQ(RADIO_IRQ_NUMBER);
+#endif
 }
 
 /**********************************************************************************************************/
 
-bool nrf_to_nrf::isValid()
+void nrf_to_nrf::hopRetuneTx(txFifoSlot_t* slot)
 {
+    hopUpdate();
 
-    uint32_t freq = NRF_RADIO->FREQUENCY;
-    NRF_RADIO->FREQUENCY = 0x4C;
-    if (NRF_RADIO->FREQUENCY == 0x4C) {
-        NRF_RADIO->FREQUENCY = freq;
-        return 1;
+    // Don't start an exchange the receiver would hop away from, wait for the next slot instead
+    uint32_t exchange = frameAirtime(slot->data[0]) + NRF_HOP_GUARD_US;
+    if (!slot->multicast && acksPerPipe[NRF_RADIO->TXADDRESS]) {
+        exchange += ackWaitTime() + txAckFrameTime;
+    }
+    uint32_t elapsed = micros() - hopSlotStart;
+    if (exchange < hopDwell && elapsed < hopDwell && hopDwell - elapsed < exchange) {
+        delayMicroseconds(hopDwell - elapsed);
+        hopUpdate();
+    }
+
+    if (hopTunedIndex != hopIndex) {
+        // The frequency is taken when ramping up, so ramp up to TX again
+        NRF_RADIO->FREQUENCY = hopChannels[hopIndex];
+        hopTunedIndex = hopIndex;
+        stopListening(false, false);
     }
-    return 0;
 }
 
 /**********************************************************************************************************/
 
-void nrf_to_nrf::setChannel(uint8_t channel, bool map) { NRF_RADIO->FREQUENCY = channel | map << RADIO_FREQUENCY_MAP_Pos; }
+void nrf_to_nrf::hopSync(uint8_t phase, uint32_t rxTime, uint8_t length)
+{
+    if (hopTunedIndex == HOP_NOT_TUNED) {
+        return;
+    }
+    // The sender took the phase, in 1/256 of the dwell time, as it started the packet. The packet was received on the
+    // channel we are tuned to, so that is the sender's slot.
+    uint32_t offset = ((uint64_t)phase * hopDwell + hopDwell / 2) >> 8;
+    hopSlotStart = rxTime - frameAirtime(length) - offset;
+    hopIndex = hopTunedIndex;
+    hopParked = false;
+    hopIdleSlots = 0;
+}
 
 /**********************************************************************************************************/
 
-uint8_t nrf_to_nrf::getChannel() { return (uint8_t)NRF_RADIO->FREQUENCY; }
+uint8_t nrf_to_nrf::hopPhase(uint32_t delay)
+{
+    uint32_t elapsed = micros() + delay - hopSlotStart;
+    if (elapsed >= hopDwell) {
+        return 0xFF;
+    }
+    return ((uint64_t)elapsed << 8) / hopDwell;
+}
 
 /**********************************************************************************************************/
 
@@ -843,6 +2374,9 @@ void nrf_to_nrf::setAutoAck(bool enable)
     if (!DPL) {
         disableDynamicPayloads(); // Called to re-configure the PCNF0 register
     }
+#if defined NRF_HW_ACK_TIMING
+    restageHwAck();
+#endif
 }
 
 /**********************************************************************************************************/
@@ -854,12 +2388,18 @@ void nrf_to_nrf::setAutoAck(uint8_t pipe, bool enable)
     if (!DPL) {
         disableDynamicPayloads(); // Called to re-configure the PCNF0 register
     }
+#if defined NRF_HW_ACK_TIMING
+    restageHwAck();
+#endif
 }
 
 /**********************************************************************************************************/
 
 void nrf_to_nrf::enableDynamicPayloads(uint8_t payloadSize)
 {
+#if defined NRF_HW_ACK_TIMING
+    hwAckFinish();
+#endif
 
     if (!DPL) {
         DPL = true;
@@ -882,6 +2422,9 @@ void nrf_to_nrf::enableDynamicPayloads(uint8_t payloadSize)
 
 void nrf_to_nrf::disableDynamicPayloads()
 {
+#if defined NRF_HW_ACK_TIMING
+    hwAckFinish();
+#endif
     DPL = false;
 
     uint8_t lenConfig = 0;
@@ -898,6 +2441,9 @@ void nrf_to_nrf::disableDynamicPayloads()
 
 void nrf_to_nrf::setPayloadSize(uint8_t size)
 {
+#if defined NRF_HW_ACK_TIMING
+    hwAckFinish();
+#endif
     staticPayloadSize = size;
     DPL = false;
 
@@ -929,6 +2475,56 @@ void nrf_to_nrf::setRetries(uint8_t retryVar, uint8_t attempts)
 
 /**********************************************************************************************************/
 
+void nrf_to_nrf::setBackoff(nrf_backoff_e policy, uint8_t cap)
+{
+    backoffPolicy = policy;
+    backoffCap = min(cap, (uint8_t)15);
+    if (policy == NRF_BACKOFF_FIXED || backoffState) {
+        return;
+    }
+    // Nodes must not share a sequence, or they would still retry together
+#if defined CCM_ENCRYPTION_ENABLED
+    #if defined NRF_RNG_POOL
+    NVIC_DisableIRQ(RNG_IRQn);
+    #endif
+    NRF_RNG->CONFIG = 1;
+    NRF_RNG->EVENTS_VALRDY = 0;
+    NRF_RNG->TASKS_START = 1;
+    for (int i = 0; i < 4; i++) {
+        if (!waitForEvent(&NRF_RNG->EVENTS_VALRDY, 10))
+            break;
+        NRF_RNG->EVENTS_VALRDY = 0;
+        backoffState = (backoffState << 8) | NRF_RNG->VALUE;
+    }
+    #if defined NRF_RNG_POOL
+    // A pool refill in progress carries on from the next byte
+    if (!(NRF_RNG->INTENSET & RNG_INTENSET_VALRDY_Msk)) {
+        NRF_RNG->TASKS_STOP = 1;
+    }
+    NVIC_EnableIRQ(RNG_IRQn);
+    #else
+    // Without the pool, takeIV() reads the RNG while encryption is enabled
+    if (NRF_CCM->ENABLE == 0) {
+        NRF_RNG->TASKS_STOP = 1;
+    }
+    #endif
+#endif
+    if (!backoffState) {
+        backoffState = micros() | 1;
+    }
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::getBackoffStats(nrf_backoff_e policy, nrf_backoff_stats_t* stats)
+{
+    if (policy < NRF_BACKOFF_POLICIES) {
+        *stats = backoffStats[policy];
+    }
+}
+
+/**********************************************************************************************************/
+
 void nrf_to_nrf::openReadingPipe(uint8_t child, uint64_t address)
 {
     uint32_t base = addrConv32(address >> 8);
@@ -961,6 +2557,9 @@ void nrf_to_nrf::openReadingPipe(uint8_t child, const uint8_t* address)
 
 void nrf_to_nrf::openReadingPipe(uint8_t child, uint32_t base, uint32_t prefix)
 {
+#if defined NRF_HW_ACK_TIMING
+    hwAckFinish();
+#endif
 
     // Using pipes 1-7 for reading pipes, leaving pipe0 for a tx pipe
     if (!child) {
@@ -984,6 +2583,14 @@ void nrf_to_nrf::openReadingPipe(uint8_t child, uint32_t base, uint32_t prefix)
         NRF_RADIO->PREFIX1 |= prefix << (8 * (child - 4));
     }
     NRF_RADIO->RXADDRESSES |= 1 << child;
+    // A new address means a new sender, don't compare its first packet against the old one
+    lastPacket[child].valid = false;
+#if defined CCM_ENCRYPTION_ENABLED
+    replayWindows[child].valid = false;
+#endif
+#if defined NRF_HW_ACK_TIMING
+    restageHwAck();
+#endif
 }
 
 /**********************************************************************************************************/
@@ -1001,6 +2608,9 @@ void nrf_to_nrf::openWritingPipe(const uint8_t* address)
 
 void nrf_to_nrf::openWritingPipe(uint32_t base, uint32_t prefix)
 {
+#if defined NRF_HW_ACK_TIMING
+    hwAckFinish();
+#endif
 
     NRF_RADIO->BASE0 = base;
     NRF_RADIO->PREFIX0 &= ~(0xFF);
@@ -1013,22 +2623,88 @@ void nrf_to_nrf::openWritingPipe(uint32_t base, uint32_t prefix)
 
 bool nrf_to_nrf::txStandBy()
 {
-    return lastTxResult;
+    while (txStage != TX_STAGE_IDLE) {
+        updateTx();
+    }
+    bool result = !txFifoFailed;
+    txFifoFailed = false;
+    return result;
 }
 
 /**********************************************************************************************************/
 
 bool nrf_to_nrf::txStandBy(uint32_t timeout, bool startTx)
 {
-    return lastTxResult;
+    uint32_t start = millis();
+    bool timedOut = false;
+    txReuse = true;
+    while (txStage != TX_STAGE_IDLE) {
+#if defined NRF_RADIO_IRQ_ENABLED
+        NVIC_DisableIRQ(RADIO_IRQ_NUMBER);
+#endif
+        if (!timedOut && millis() - start > timeout) {
+            // Drop the payloads queued behind the one on air, that one only gets to finish its current attempt
+            timedOut = true;
+            txReuse = false;
+            if (txFifoCount > 1) {
+                txFifoTail = (txFifoHead + 1) % NRF_TX_FIFO_SIZE;
+                txFifoCount = 1;
+                txFifoFailed = true;
+            }
+        }
+        bool dropped = timedOut && txStage == TX_STAGE_RETRY_DELAY;
+        if (dropped) {
+            NRF_TX_STAGE_END(NRF_STAGE_RETRY_DELAY);
+            txRestoreRx();
+            txComplete(false);
+        }
+#if defined NRF_RADIO_IRQ_ENABLED
+        NVIC_EnableIRQ(RADIO_IRQ_NUMBER);
+#endif
+        if (dropped) {
+            break;
+        }
+        updateTx();
+    }
+    txReuse = false;
+    bool result = !txFifoFailed && lastTxResult;
+    txFifoFailed = false;
+    return result;
 }
 
 /**********************************************************************************************************/
 
 bool nrf_to_nrf::writeFast(void* buf, uint8_t len, bool multicast)
 {
-    lastTxResult = write(buf, len, multicast);
-    return lastTxResult;
+    if (txFifoFailed) {
+        return 0;
+    }
+    // Same as the nRF24, block while the TX FIFO is full
+    while (txFifoCount >= NRF_TX_FIFO_SIZE) {
+        updateTx();
+        if (txFifoFailed) {
+            return 0;
+        }
+    }
+    return writeAsync(buf, len, multicast);
+}
+
+/**********************************************************************************************************/
+
+uint8_t nrf_to_nrf::flush_tx()
+{
+    // The payload currently on air (if any) is kept and allowed to complete
+#if defined NRF_RADIO_IRQ_ENABLED
+    NVIC_DisableIRQ(RADIO_IRQ_NUMBER);
+#endif
+    uint8_t keep = (txStage != TX_STAGE_IDLE) ? 1 : 0;
+    txFifoTail = (txFifoHead + keep) % NRF_TX_FIFO_SIZE;
+    txFifoCount = keep;
+#if defined NRF_RADIO_IRQ_ENABLED
+    NVIC_EnableIRQ(RADIO_IRQ_NUMBER);
+#endif
+    flushAckPayloads();
+    return 0;
 }
 
 /**********************************************************************************************************/
@@ -1050,27 +2726,25 @@ bool nrf_to_nrf::isChipConnected() { return isValid(); }
 
 bool nrf_to_nrf::setDataRate(uint8_t speed)
 {
+#if defined NRF_HW_ACK_TIMING
+    hwAckFinish();
+#endif
 
     if (speed == NRF_1MBPS) {
         NRF_RADIO->MODE = (RADIO_MODE_MODE_Nrf_1Mbit << RADIO_MODE_MODE_Pos);
-        ackTimeout = ACK_TIMEOUT_1MBPS;
     }
     else if (speed == NRF_250KBPS) {
         NRF_RADIO->MODE = (RADIO_MODE_MODE_Nrf_250Kbit << RADIO_MODE_MODE_Pos);
-        ackTimeout = ACK_TIMEOUT_250KBPS;
     }
     else if (speed == NRF_2MBPS) { // NRF_2MBPS
         NRF_RADIO->MODE = (RADIO_MODE_MODE_Nrf_2Mbit << RADIO_MODE_MODE_Pos);
-        ackTimeout = ACK_TIMEOUT_2MBPS;
     }
 #ifdef ARDUINO_NRF54L15
     else if (speed == NRF_4MBPS_OBT4) {
         NRF_RADIO->MODE = (RADIO_MODE_MODE_Nrf_4Mbit_OBT4 << RADIO_MODE_MODE_Pos);
-        ackTimeout = ACK_TIMEOUT_2MBPS;
     }
     else {
         NRF_RADIO->MODE = (RADIO_MODE_MODE_Nrf_4Mbit_OBT6 << RADIO_MODE_MODE_Pos);
-        ackTimeout = ACK_TIMEOUT_2MBPS;
     }
 #endif
 
@@ -1081,6 +2755,9 @@ bool nrf_to_nrf::setDataRate(uint8_t speed)
 
 void nrf_to_nrf::setPALevel(uint8_t level, bool lnaEnable)
 {
+#if defined NRF_HW_ACK_TIMING
+    hwAckFinish();
+#endif
 
     uint8_t paLevel = 0x00;
 
@@ -1134,6 +2811,9 @@ uint8_t nrf_to_nrf::getARC()
 
 void nrf_to_nrf::setCRCLength(nrf_crclength_e length)
 {
+#if defined NRF_HW_ACK_TIMING
+    hwAckFinish();
+#endif
     if (length == NRF_CRC_24) {
         NRF_RADIO->CRCCNF = RADIO_CRCCNF_LEN_Three; /* CRC configuration: 24bit */
         NRF_RADIO->CRCINIT = 0x555555UL;            // Initial value
@@ -1158,102 +2838,461 @@ void nrf_to_nrf::setCRCLength(nrf_crclength_e length)
 
 /**********************************************************************************************************/
 
-nrf_crclength_e nrf_to_nrf::getCRCLength()
+nrf_crclength_e nrf_to_nrf::getCRCLength()
+{
+    if (NRF_RADIO->CRCCNF == 0) {
+        return NRF_CRC_DISABLED;
+    }
+    else if (NRF_RADIO->CRCCNF == RADIO_CRCCNF_LEN_One) {
+        return NRF_CRC_8;
+    }
+    if (NRF_RADIO->CRCCNF == RADIO_CRCCNF_LEN_Two) {
+        return NRF_CRC_16;
+    }
+    else {
+        return NRF_CRC_24;
+    }
+}
+
+/**********************************************************************************************************/
+
+bool nrf_to_nrf::testCarrier(uint8_t RSSI)
+{
+#ifndef ARDUINO_NRF54L15
+    NRF_RADIO->EVENTS_RSSIEND = 0;
+    NRF_RADIO->TASKS_RSSISTART = 1;
+    if (!waitForEvent(&NRF_RADIO->EVENTS_RSSIEND))
+        return false;
+
+    if (NRF_RADIO->RSSISAMPLE < RSSI) {
+        return 1;
+    }
+#endif
+    return 0;
+}
+
+/**********************************************************************************************************/
+
+bool nrf_to_nrf::testRPD(uint8_t RSSI)
+{
+    return testCarrier(RSSI);
+}
+
+/**********************************************************************************************************/
+
+uint8_t nrf_to_nrf::getRSSI()
+{
+#ifndef ARDUINO_NRF54L15
+    NRF_RADIO->EVENTS_RSSIEND = 0;
+    NRF_RADIO->TASKS_RSSISTART = 1;
+    if (!waitForEvent(&NRF_RADIO->EVENTS_RSSIEND))
+        return 0;
+
+    return (uint8_t)NRF_RADIO->RSSISAMPLE;
+#endif
+    return 0;
+}
+
+/**********************************************************************************************************/
+
+uint8_t nrf_to_nrf::getPacketRSSI() { return rxLastRSSI; }
+
+/**********************************************************************************************************/
+
+bool nrf_to_nrf::setListenBeforeTalk(bool enable, uint8_t threshold)
+{
+#ifdef NRF_HAS_ENERGY_DETECT
+    // EDSAMPLE counts up from -93dBm, 0 would make any energy a busy channel
+    ccaThreshold = enable ? ED_RSSIOFFS - min(threshold, (uint8_t)(ED_RSSIOFFS - 1)) : 0;
+    return 1;
+#else
+    (void)enable;
+    (void)threshold;
+    return 0;
+#endif
+}
+
+/**********************************************************************************************************/
+
+bool nrf_to_nrf::scanChannels(uint8_t firstChannel, uint8_t lastChannel, nrf_scan_result_t* results, uint8_t samples, bool energyDetect)
+{
+#ifndef ARDUINO_NRF54L15
+    if (txStage != TX_STAGE_IDLE || firstChannel > lastChannel || !samples) {
+        return false;
+    }
+    clockReady();
+    #ifndef NRF_HAS_ENERGY_DETECT
+    energyDetect = false;
+    #endif
+    bool listening = inRxMode;
+    uint32_t frequency = NRF_RADIO->FREQUENCY;
+    uint32_t rxAddresses = NRF_RADIO->RXADDRESSES;
+    uint32_t modeConfig = NRF_RADIO->MODECNF0;
+    #if defined NRF_RADIO_IRQ_ENABLED
+    NRF_RADIO->RADIO_INTENCLR = RADIO_IRQ_RX_MASK;
+    #endif
+    #if defined NRF_HW_ACK_TIMING
+    hwAckFinish();
+    disarmAckTimer();
+    #endif
+
+    NRF_RADIO->SHORTS = 0;
+    NRF_RADIO->EVENTS_DISABLED = 0;
+    NRF_RADIO->TASKS_DISABLE = 1;
+    bool ok = waitForEvent(&NRF_RADIO->EVENTS_DISABLED);
+    NRF_RADIO->RXADDRESSES = 0;
+    NRF_RADIO->MODECNF0 |= 1;
+    // Every DISABLE ramps the receiver up again on the next channel. RSSI is sampled in RX, ED in RXIDLE.
+    NRF_RADIO->SHORTS = RADIO_SHORTS_DISABLED_RXEN_Msk | (energyDetect ? 0 : RADIO_SHORTS_READY_START_Msk);
+    #ifdef NRF_HAS_ENERGY_DETECT
+    NRF_RADIO->EDCNT = 0;
+    #endif
+
+    for (uint16_t channel = firstChannel; ok && channel <= lastChannel; channel++) {
+        NRF_RADIO->FREQUENCY = channel;
+        NRF_RADIO->EVENTS_RXREADY = 0;
+        if (channel == firstChannel) {
+            NRF_RADIO->TASKS_RXEN = 1;
+        }
+        else {
+            NRF_RADIO->TASKS_DISABLE = 1;
+        }
+        if (!(ok = waitForEvent(&NRF_RADIO->EVENTS_RXREADY))) {
+            break;
+        }
+        if (!energyDetect) {
+            delayMicroseconds(RSSI_SETTLE_US);
+        }
+
+        uint8_t peak = 0xFF;
+        uint16_t sum = 0;
+        for (uint8_t i = 0; i < samples; i++) {
+            uint8_t level;
+    #ifdef NRF_HAS_ENERGY_DETECT
+            if (energyDetect) {
+                NRF_RADIO->EVENTS_EDEND = 0;
+                NRF_RADIO->TASKS_EDSTART = 1;
+                if (!(ok = waitForEvent(&NRF_RADIO->EVENTS_EDEND))) {
+                    break;
+                }
+                level = ED_RSSIOFFS - min((uint32_t)ED_RSSIOFFS, (uint32_t)NRF_RADIO->EDSAMPLE);
+            }
+            else {
+    #endif
+                NRF_RADIO->EVENTS_RSSIEND = 0;
+                NRF_RADIO->TASKS_RSSISTART = 1;
+                if (!(ok = waitForEvent(&NRF_RADIO->EVENTS_RSSIEND))) {
+                    break;
+                }
+                level = (uint8_t)NRF_RADIO->RSSISAMPLE;
+    #ifdef NRF_HAS_ENERGY_DETECT
+            }
+    #endif
+            peak = min(peak, level);
+            sum += level;
+        }
+        results[channel - firstChannel].peak = peak;
+        results[channel - firstChannel].average = sum / samples;
+    }
+
+    NRF_RADIO->SHORTS = 0;
+    NRF_RADIO->EVENTS_DISABLED = 0;
+    NRF_RADIO->TASKS_DISABLE = 1;
+    waitForEvent(&NRF_RADIO->EVENTS_DISABLED);
+    NRF_RADIO->FREQUENCY = frequency;
+    NRF_RADIO->RXADDRESSES = rxAddresses;
+    NRF_RADIO->MODECNF0 = modeConfig;
+    if (listening) {
+        startListening(false);
+    }
+    else {
+        stopListening(false, false);
+    }
+    return ok;
+#else
+    return false;
+#endif
+}
+
+/**********************************************************************************************************/
+
+uint8_t nrf_to_nrf::flush_rx()
+{
+#if defined NRF_RADIO_IRQ_ENABLED
+    NVIC_DisableIRQ(RADIO_IRQ_NUMBER);
+#endif
+    rxFifoHead = 0;
+    rxFifoTail = 0;
+    rxFifoCount = 0;
+#if defined NRF_RADIO_IRQ_ENABLED
+    if (inRxMode && txStage == TX_STAGE_IDLE) {
+        NRF_RADIO->RADIO_INTENSET = RADIO_IRQ_RX_MASK;
+    }
+    NVIC_EnableIRQ(RADIO_IRQ_NUMBER);
+#endif
+    return 0;
+}
+
+/**********************************************************************************************************/
+
+#ifndef ARDUINO_NRF54L15
+// Radio registers that hold the configuration, switching the radio off resets them. The first NRF_PROFILE_REGS
+// don't depend on the RX/TX mode and make up a nrf_radio_profile_t
+static const uint16_t radioShadowRegs[] = {
+    offsetof(NRF_RADIO_Type, PCNF0),     offsetof(NRF_RADIO_Type, PCNF1),       offsetof(NRF_RADIO_Type, BASE0),
+    offsetof(NRF_RADIO_Type, BASE1),     offsetof(NRF_RADIO_Type, PREFIX0),     offsetof(NRF_RADIO_Type, PREFIX1),
+    offsetof(NRF_RADIO_Type, TXADDRESS), offsetof(NRF_RADIO_Type, RXADDRESSES), offsetof(NRF_RADIO_Type, CRCCNF),
+    offsetof(NRF_RADIO_Type, CRCINIT),   offsetof(NRF_RADIO_Type, CRCPOLY),     offsetof(NRF_RADIO_Type, MODE),
+    offsetof(NRF_RADIO_Type, TXPOWER),   offsetof(NRF_RADIO_Type, FREQUENCY),   offsetof(NRF_RADIO_Type, MODECNF0),
+    offsetof(NRF_RADIO_Type, TIFS),      offsetof(NRF_RADIO_Type, PACKETPTR),   offsetof(NRF_RADIO_Type, SHORTS),
+    #ifdef NRF_HAS_ENERGY_DETECT
+    offsetof(NRF_RADIO_Type, CCACTRL),
+    #endif
+};
+static_assert(sizeof(radioShadowRegs) / sizeof(radioShadowRegs[0]) <= NRF_RADIO_SHADOW_REGS, "NRF_RADIO_SHADOW_REGS");
+#endif
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::powerUp()
+{
+#ifndef ARDUINO_NRF54L15
+    NRF_CLOCK->EVENTS_HFCLKSTARTED = 0;
+    NRF_CLOCK->TASKS_HFCLKSTART = 1;
+
+    // Configure the radio while the external oscillator starts up, clockReady() waits for it
+    if (!NRF_RADIO->POWER) {
+        NRF_RADIO->POWER = 1;
+        for (uint8_t i = 0; i < sizeof(radioShadowRegs) / sizeof(radioShadowRegs[0]); i++) {
+            *(volatile uint32_t*)((uint8_t*)NRF_RADIO + radioShadowRegs[i]) = radioShadow[i];
+        }
+        NRF_RADIO->INTENSET = radioShadowInten;
+    }
+#else
+    NRF_POWER->TASKS_CONSTLAT = 1;
+    NRF_CLOCK->EVENTS_XOSTARTED = 0;
+    NRF_CLOCK->TASKS_XOSTART = 1;
+#endif
+    clockPending = true;
+
+#ifdef CCM_ENCRYPTION_ENABLED
+    if (enableEncryption) {
+        NRF_RNG->CONFIG = 1;
+    #if defined NRF_RNG_POOL
+        rngRefill();
+    #else
+        NRF_RNG->TASKS_START = 1;
+    #endif
+        NRF_CCM->ENABLE = 2;
+    }
+#endif
+}
+
+/**********************************************************************************************************/
+
+bool nrf_to_nrf::startDutyCycle(uint32_t window, uint32_t period)
 {
-    if (NRF_RADIO->CRCCNF == 0) {
-        return NRF_CRC_DISABLED;
-    }
-    else if (NRF_RADIO->CRCCNF == RADIO_CRCCNF_LEN_One) {
-        return NRF_CRC_8;
-    }
-    if (NRF_RADIO->CRCCNF == RADIO_CRCCNF_LEN_Two) {
-        return NRF_CRC_16;
-    }
-    else {
-        return NRF_CRC_24;
+#if defined NRF_DUTY_CYCLE
+    uint32_t windowTicks = ((uint64_t)window * 32768 + 999999) / 1000000;
+    uint32_t leadTicks = ((uint64_t)NRF_DUTY_XO_LEAD_US * 32768 + 999999) / 1000000;
+    uint64_t periodTicks = (uint64_t)period * 32768 / 1000000;
+    if (!inRxMode || hopCount || !windowTicks || 1 + leadTicks + windowTicks >= periodTicks || periodTicks > 0xFFFFFF) {
+        return 0;
     }
+    if (dutyWindowTicks) {
+        dutyDisarm();
+    }
+    #if defined NRF_HW_ACK_TIMING
+    dutyShorts = rxShorts;
+    #else
+    dutyShorts = RX_RSSI_SHORTS;
+    #endif
+    dutyWindowTicks = windowTicks;
+    // Still listening, available() closes the radio like a window that has ended
+    dutyOpen = true;
+    dutyHold = false;
+
+    // Each period starts the HFXO at tick 1 & opens the window once it is running, closes it windowTicks later,
+    // then clears the counter
+    NRF_DUTY_RTC->TASKS_STOP = 1;
+    NRF_DUTY_RTC->TASKS_CLEAR = 1;
+    NRF_DUTY_RTC->PRESCALER = 0;
+    NRF_DUTY_RTC->CC[0] = 1;
+    NRF_DUTY_RTC->CC[1] = 1 + leadTicks;
+    NRF_DUTY_RTC->CC[2] = 1 + leadTicks + windowTicks;
+    NRF_DUTY_RTC->CC[3] = periodTicks;
+    NRF_DUTY_RTC->EVENTS_COMPARE[0] = 0;
+    NRF_DUTY_RTC->EVENTS_COMPARE[1] = 0;
+    NRF_DUTY_RTC->EVENTS_COMPARE[2] = 0;
+    NRF_DUTY_RTC->EVENTS_COMPARE[3] = 0;
+    NRF_DUTY_RTC->EVTENSET = RTC_EVTEN_COMPARE0_Msk | RTC_EVTEN_COMPARE1_Msk | RTC_EVTEN_COMPARE2_Msk | RTC_EVTEN_COMPARE3_Msk;
+
+    NRF_PPI->CH[NRF_DUTY_PPI_CH].EEP = (uint32_t)&NRF_DUTY_RTC->EVENTS_COMPARE[0];
+    NRF_PPI->CH[NRF_DUTY_PPI_CH].TEP = (uint32_t)&NRF_CLOCK->TASKS_HFCLKSTART;
+    NRF_PPI->CH[NRF_DUTY_PPI_CH + 1].EEP = (uint32_t)&NRF_DUTY_RTC->EVENTS_COMPARE[1];
+    NRF_PPI->CH[NRF_DUTY_PPI_CH + 1].TEP = (uint32_t)&NRF_RADIO->TASKS_RXEN;
+    NRF_PPI->FORK[NRF_DUTY_PPI_CH + 1].TEP = (uint32_t)&NRF_PPI->TASKS_CHG[NRF_DUTY_PPI_GROUP].EN;
+    NRF_PPI->CH[NRF_DUTY_PPI_CH + 2].EEP = (uint32_t)&NRF_DUTY_RTC->EVENTS_COMPARE[3];
+    NRF_PPI->CH[NRF_DUTY_PPI_CH + 2].TEP = (uint32_t)&NRF_DUTY_RTC->TASKS_CLEAR;
+    // The window is closed by the RTC unless a packet arrives in it, available() closes it after the packet & ACK
+    NRF_PPI->CH[NRF_DUTY_PPI_CH + 3].EEP = (uint32_t)&NRF_DUTY_RTC->EVENTS_COMPARE[2];
+    NRF_PPI->CH[NRF_DUTY_PPI_CH + 3].TEP = (uint32_t)&NRF_RADIO->TASKS_DISABLE;
+    NRF_PPI->CH[NRF_DUTY_PPI_CH + 4].EEP = (uint32_t)&NRF_RADIO->EVENTS_ADDRESS;
+    NRF_PPI->CH[NRF_DUTY_PPI_CH + 4].TEP = (uint32_t)&NRF_PPI->TASKS_CHG[NRF_DUTY_PPI_GROUP].DIS;
+    NRF_PPI->CHG[NRF_DUTY_PPI_GROUP] = 1 << (NRF_DUTY_PPI_CH + 3);
+    NRF_PPI->CHENSET = 0x1F << NRF_DUTY_PPI_CH;
+    NRF_DUTY_RTC->TASKS_START = 1;
+    return 1;
+#else
+    (void)window;
+    (void)period;
+    return 0;
+#endif
 }
 
 /**********************************************************************************************************/
 
-bool nrf_to_nrf::testCarrier(uint8_t RSSI)
+void nrf_to_nrf::stopDutyCycle()
 {
-#ifndef ARDUINO_NRF54L15
-    NRF_RADIO->EVENTS_RSSIEND = 0;
-    NRF_RADIO->TASKS_RSSISTART = 1;
-    if (!waitForEvent(&NRF_RADIO->EVENTS_RSSIEND))
-        return false;
-
-    if (NRF_RADIO->RSSISAMPLE < RSSI) {
-        return 1;
+#if defined NRF_DUTY_CYCLE
+    if (!dutyWindowTicks) {
+        return;
+    }
+    bool closed = !dutyOpen || dutyClosedByRtc();
+    dutyDisarm();
+    if (closed && inRxMode) {
+        startListening(false);
     }
 #endif
-    return 0;
 }
 
 /**********************************************************************************************************/
 
-bool nrf_to_nrf::testRPD(uint8_t RSSI)
+#if defined NRF_DUTY_CYCLE
+void nrf_to_nrf::dutyUpdate()
 {
-    return testCarrier(RSSI);
+    if (NRF_DUTY_RTC->EVENTS_COMPARE[1] && NRF_RADIO->STATE != RADIO_STATE_STATE_RxRu) {
+        // The RTC has opened the next window & READY_START has started RX, the usual listening shorts take over again
+        NRF_DUTY_RTC->EVENTS_COMPARE[1] = 0;
+        if (NRF_RADIO->STATE == RADIO_STATE_STATE_RxIdle) {
+            // Closed by the RTC before available() could add READY_START
+            NRF_RADIO->TASKS_START = 1;
+        }
+        NRF_RADIO->SHORTS = dutyShorts;
+        NRF_RADIO->EVENTS_ADDRESS = 0;
+        dutyOpen = true;
+        dutyHold = false;
+    }
+    if (!dutyOpen) {
+        return;
+    }
+    // Also past the end once the counter has been cleared for the next period
+    uint32_t elapsed = (NRF_DUTY_RTC->COUNTER - NRF_DUTY_RTC->CC[1]) & 0xFFFFFF;
+    if (elapsed < dutyWindowTicks) {
+        return;
+    }
+
+    #if defined NRF_RADIO_IRQ_ENABLED
+    NVIC_DisableIRQ(RADIO_IRQ_NUMBER);
+    #endif
+    bool busy = false;
+    if (!dutyClosedByRtc()) {
+        // A packet arrived, so the RTC left the window open. The radio is disabled after it until it is handled.
+        uint32_t state = NRF_RADIO->STATE;
+        busy = state != RADIO_STATE_STATE_Rx && state != RADIO_STATE_STATE_RxIdle && state != RADIO_STATE_STATE_Disabled; // Sending an ACK
+    #if defined NRF_HW_ACK_TIMING
+        busy |= rxTurn != RX_TURN_NONE;
+    #endif
+        if (!busy && NRF_RADIO->EVENTS_ADDRESS) {
+            // A packet or ACK started since the last look, give it & its ACK time to end
+            NRF_RADIO->EVENTS_ADDRESS = 0;
+            dutyHold = true;
+            dutyHoldTime = micros();
+            busy = true;
+        }
+        if (!busy && dutyHold) {
+            busy = micros() - dutyHoldTime < frameAirtime(NRF_RADIO->PCNF1 & 0xFF) + ackWaitTime();
+        }
+    }
+    if (!busy) {
+        // Disabled without the shorts turning the radio around, READY_START then starts RX once the RTC enables it
+        NRF_RADIO->SHORTS = 0;
+        NRF_RADIO->EVENTS_DISABLED = 0;
+        NRF_RADIO->TASKS_DISABLE = 1;
+        waitForEvent(&NRF_RADIO->EVENTS_DISABLED);
+        NRF_RADIO->SHORTS = dutyShorts | RADIO_SHORTS_READY_START_Msk;
+    #if defined NRF_DUTY_STOP_HFXO
+        NRF_CLOCK->TASKS_HFCLKSTOP = 1;
+        NRF_CLOCK->EVENTS_HFCLKSTARTED = 0;
+    #endif
+        dutyOpen = false;
+    }
+    #if defined NRF_RADIO_IRQ_ENABLED
+    NVIC_EnableIRQ(RADIO_IRQ_NUMBER);
+    #endif
 }
 
 /**********************************************************************************************************/
 
-uint8_t nrf_to_nrf::getRSSI()
+bool nrf_to_nrf::dutyClosedByRtc()
 {
-#ifndef ARDUINO_NRF54L15
-    NRF_RADIO->EVENTS_RSSIEND = 0;
-    NRF_RADIO->TASKS_RSSISTART = 1;
-    if (!waitForEvent(&NRF_RADIO->EVENTS_RSSIEND))
-        return 0;
-
-    return (uint8_t)NRF_RADIO->RSSISAMPLE;
-#endif
-    return 0;
+    // The close channel is only still enabled after the window if no packet arrived in it
+    uint32_t elapsed = (NRF_DUTY_RTC->COUNTER - NRF_DUTY_RTC->CC[1]) & 0xFFFFFF;
+    return elapsed >= dutyWindowTicks && (NRF_PPI->CHEN & (1UL << (NRF_DUTY_PPI_CH + 3))) && NRF_RADIO->STATE == RADIO_STATE_STATE_Disabled;
 }
 
 /**********************************************************************************************************/
 
-uint8_t nrf_to_nrf::flush_rx()
+void nrf_to_nrf::dutyDisarm()
 {
-    return 0;
+    NRF_PPI->CHENCLR = 0x1F << NRF_DUTY_PPI_CH;
+    NRF_DUTY_RTC->TASKS_STOP = 1;
+    NRF_DUTY_RTC->EVTENCLR = RTC_EVTEN_COMPARE0_Msk | RTC_EVTEN_COMPARE1_Msk | RTC_EVTEN_COMPARE2_Msk | RTC_EVTEN_COMPARE3_Msk;
+    dutyWindowTicks = 0;
+    #if defined NRF_DUTY_STOP_HFXO
+    if (!dutyOpen) {
+        // Started by the RTC if the next window was about to open, the event is still set then
+        NRF_CLOCK->TASKS_HFCLKSTART = 1;
+        waitForEvent(&NRF_CLOCK->EVENTS_HFCLKSTARTED);
+    }
+    #endif
 }
 
 /**********************************************************************************************************/
+#endif
 
-void nrf_to_nrf::powerUp()
+void nrf_to_nrf::clockReady()
 {
+    if (clockPending) {
+        clockPending = false;
 #ifndef ARDUINO_NRF54L15
-    NRF_CLOCK->EVENTS_HFCLKSTARTED = 0;
-    NRF_CLOCK->TASKS_HFCLKSTART = 1;
-
-    /* Wait for the external oscillator to start up */
-    waitForEvent(&NRF_CLOCK->EVENTS_HFCLKSTARTED);
-
-    NRF_RADIO->POWER = 1;
+        waitForEvent(&NRF_CLOCK->EVENTS_HFCLKSTARTED);
 #else
-    NRF_POWER->TASKS_CONSTLAT = 1;
-    NRF_CLOCK->EVENTS_XOSTARTED = 0;
-    NRF_CLOCK->TASKS_XOSTART = 1;
-
-    waitForEvent(&NRF_CLOCK->EVENTS_XOSTARTED);
+        waitForEvent(&NRF_CLOCK->EVENTS_XOSTARTED);
 #endif
-
-#ifdef CCM_ENCRYPTION_ENABLED
-    if (enableEncryption) {
-        NRF_RNG->CONFIG = 1;
-        NRF_RNG->TASKS_START = 1;
-        NRF_CCM->ENABLE = 2;
     }
-#endif
 }
 
 /**********************************************************************************************************/
 
 void nrf_to_nrf::powerDown()
 {
+#if defined NRF_DUTY_CYCLE
+    if (dutyWindowTicks) {
+        dutyDisarm();
+    }
+#endif
 #ifndef ARDUINO_NRF54L15
+    if (NRF_RADIO->POWER) {
+    #if defined NRF_HW_ACK_TIMING
+        hwAckFinish();
+        disarmAckTimer();
+    #endif
+        for (uint8_t i = 0; i < sizeof(radioShadowRegs) / sizeof(radioShadowRegs[0]); i++) {
+            radioShadow[i] = *(volatile uint32_t*)((uint8_t*)NRF_RADIO + radioShadowRegs[i]);
+        }
+        radioShadowInten = NRF_RADIO->INTENSET;
+    }
     NRF_RADIO->POWER = 0;
     NRF_CLOCK->TASKS_HFCLKSTOP = 1;
 #else
@@ -1262,6 +3301,9 @@ void nrf_to_nrf::powerDown()
 
 #ifdef CCM_ENCRYPTION_ENABLED
     if (enableEncryption) {
+    #if defined NRF_RNG_POOL
+        NRF_RNG->INTENCLR = RNG_INTENSET_VALRDY_Msk;
+    #endif
         NRF_RNG->TASKS_STOP = 1;
         NRF_RNG->CONFIG = 0;
         NRF_CCM->ENABLE = 0;
@@ -1269,9 +3311,144 @@ void nrf_to_nrf::powerDown()
 #endif
 }
 
+/**********************************************************************************************************/
+
+bool nrf_to_nrf::saveProfile(nrf_radio_profile_t* profile)
+{
+#ifndef ARDUINO_NRF54L15
+    for (uint8_t i = 0; i < NRF_PROFILE_REGS; i++) {
+        profile->regs[i] = *(volatile uint32_t*)((uint8_t*)NRF_RADIO + radioShadowRegs[i]);
+    #if defined NRF_HW_ACK_TIMING
+        if (radioShadowRegs[i] == offsetof(NRF_RADIO_Type, TXADDRESS) && (rxAckStaged || rxTurn == RX_TURN_ACK)) {
+            profile->regs[i] = ackTxAddress; // Borrowed by the ACK waiting to go out
+        }
+    #endif
+    }
+    profile->rxBase = rxBase;
+    profile->rxPrefix = rxPrefix;
+    profile->txBase = txBase;
+    profile->txPrefix = txPrefix;
+    profile->interframeSpacing = interframeSpacing;
+    profile->staticPayloadSize = staticPayloadSize;
+    profile->acksPerPipe = 0;
+    for (uint8_t i = 0; i < 8; i++) {
+        profile->acksPerPipe |= acksPerPipe[i] << i;
+    }
+    profile->retries = retries;
+    profile->retryDuration = retryDuration;
+    profile->dpl = DPL;
+    profile->ackPayloads = ackPayloadsEnabled;
+    profile->dynamicAck = dynamicAckEnabled;
+    #if defined CCM_ENCRYPTION_ENABLED
+    profile->encryption = enableEncryption;
+    memcpy(profile->key, ccmData.key, CCM_KEY_SIZE);
+    #endif
+    // The receive state so far belongs to the active profile, a new one starts clean
+    if (activeProfile && activeProfile != profile) {
+        storeProfileState();
+        memset(lastPacket, 0, sizeof(lastPacket));
+    #if defined CCM_ENCRYPTION_ENABLED
+        memset(replayWindows, 0, sizeof(replayWindows));
+    #endif
+    }
+    activeProfile = profile;
+    storeProfileState();
+    profile->valid = true;
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::storeProfileState()
+{
+    memcpy(activeProfile->lastPacket, lastPacket, sizeof(lastPacket));
+#if defined CCM_ENCRYPTION_ENABLED
+    memcpy(activeProfile->replayWindows, replayWindows, sizeof(replayWindows));
+#endif
+}
+
+/**********************************************************************************************************/
+
+bool nrf_to_nrf::applyProfile(nrf_radio_profile_t* profile)
+{
+#ifndef ARDUINO_NRF54L15
+    if (!profile->valid || txStage != TX_STAGE_IDLE || hopCount) {
+        return 0;
+    }
+    #if defined NRF_DUTY_CYCLE
+    if (dutyWindowTicks) {
+        return 0;
+    }
+    #endif
+    #if defined NRF_RADIO_IRQ_ENABLED
+    NRF_RADIO->RADIO_INTENCLR = RADIO_IRQ_RX_MASK;
+    #endif
+    #if defined NRF_HW_ACK_TIMING
+    hwAckFinish();
+    disarmAckTimer();
+    #endif
+    // The radio latches the channel & packet format at ramp-up, switch with it disabled & ramp up again
+    NRF_RADIO->SHORTS = 0;
+    NRF_RADIO->EVENTS_DISABLED = 0;
+    NRF_RADIO->TASKS_DISABLE = 1;
+    if (!waitForEvent(&NRF_RADIO->EVENTS_DISABLED)) {
+        return 0;
+    }
+    for (uint8_t i = 0; i < NRF_PROFILE_REGS; i++) {
+        *(volatile uint32_t*)((uint8_t*)NRF_RADIO + radioShadowRegs[i]) = profile->regs[i];
+    }
+    rxBase = profile->rxBase;
+    rxPrefix = profile->rxPrefix;
+    txBase = profile->txBase;
+    txPrefix = profile->txPrefix;
+    interframeSpacing = profile->interframeSpacing;
+    staticPayloadSize = profile->staticPayloadSize;
+    for (uint8_t i = 0; i < 8; i++) {
+        acksPerPipe[i] = (profile->acksPerPipe >> i) & 1;
+    }
+    retries = profile->retries;
+    retryDuration = profile->retryDuration;
+    DPL = profile->dpl;
+    ackPayloadsEnabled = profile->ackPayloads;
+    dynamicAckEnabled = profile->dynamicAck;
+    // Each network has its own senders, keep what was accepted from them for when it is switched back to
+    if (profile != activeProfile) {
+        if (activeProfile) {
+            storeProfileState();
+        }
+        memcpy(lastPacket, profile->lastPacket, sizeof(lastPacket));
+    #if defined CCM_ENCRYPTION_ENABLED
+        memcpy(replayWindows, profile->replayWindows, sizeof(replayWindows));
+    #endif
+        activeProfile = profile;
+    }
+    // ACK payloads are addressed to the old senders
+    flushAckPayloads();
+    #if defined CCM_ENCRYPTION_ENABLED
+    enableEncryption = profile->encryption;
+    memcpy(ccmData.key, profile->key, CCM_KEY_SIZE);
+    #endif
+    if (inRxMode) {
+        startListening();
+    }
+    else {
+        stopListening(true, true);
+    }
+    return 1;
+#else
+    return 0;
+#endif
+}
+
 /**********************************************************************************************************/
 void nrf_to_nrf::setAddressWidth(uint8_t a_width)
 {
+#if defined NRF_HW_ACK_TIMING
+    hwAckFinish();
+#endif
     NRF_RADIO->PCNF1 &= ~(0xFF << RADIO_PCNF1_BALEN_Pos);
     NRF_RADIO->PCNF1 |= (a_width - 1) << RADIO_PCNF1_BALEN_Pos;
 }
@@ -1375,7 +3552,6 @@ void nrf_to_nrf::printDetails()
 
 uint8_t nrf_to_nrf::encrypt(void* bufferIn, uint8_t size)
 {
-    NRF_CCM->MODE = 0 | 1 << 24 | 1 << 16;
 
     if (!size) {
         return 0;
@@ -1384,30 +3560,15 @@ uint8_t nrf_to_nrf::encrypt(void* bufferIn, uint8_t size)
         return 0;
     }
 
-    inBuffer[0] = 0;
-    inBuffer[1] = size;
-    inBuffer[2] = 0;
-
     memcpy(&inBuffer[CCM_START_SIZE], bufferIn, size);
-    memset(outBuffer, 0, sizeof(outBuffer));
-
-    NRF_CCM->EVENTS_ENDKSGEN = 0;
-    NRF_CCM->EVENTS_ENDCRYPT = 0;
-    NRF_CCM->TASKS_KSGEN = 1;
-    if (!waitForEvent(&NRF_CCM->EVENTS_ENDCRYPT))
-        return 0;
-
-    if (NRF_CCM->EVENTS_ERROR) {
-        return 0;
-    }
-    return outBuffer[1];
+    ccmStart(inBuffer, size, false);
+    return ccmFinish();
 }
 
 /**********************************************************************************************************/
 
 uint8_t nrf_to_nrf::decrypt(void* bufferIn, uint8_t size)
 {
-    NRF_CCM->MODE = 1 | 1 << 24 | 1 << 16;
 
     if (!size) {
         return 0;
@@ -1417,25 +3578,55 @@ uint8_t nrf_to_nrf::decrypt(void* bufferIn, uint8_t size)
     }
 
     memcpy(&inBuffer[CCM_START_SIZE], bufferIn, size);
+    ccmStart(inBuffer, size, true);
+    return ccmFinish();
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::ccmStart(uint8_t* data, uint8_t size, bool decrypt)
+{
+
+    // The CCM reads CNFPTR & INPTR until it is done, so never restart it mid operation
+    if (ccmBusy) {
+        ccmFinish();
+    }
 
-    inBuffer[0] = 0;
-    inBuffer[1] = size;
-    inBuffer[2] = 0;
+    // data points at CCM_START_SIZE bytes of header space in front of the payload
+    data[0] = 0;
+    data[1] = size;
+    data[2] = 0;
 
-    memset(outBuffer, 0, sizeof(outBuffer));
+    NRF_CCM->MODE = (decrypt ? 1 : 0) | 1 << 24 | 1 << 16;
+    NRF_CCM->INPTR = (uint32_t)data;
+    ccmDecrypting = decrypt;
+    ccmBusy = true;
 
     NRF_CCM->EVENTS_ENDKSGEN = 0;
     NRF_CCM->EVENTS_ENDCRYPT = 0;
+    NRF_CCM->EVENTS_ERROR = 0;
     NRF_CCM->TASKS_KSGEN = 1;
+}
+
+/**********************************************************************************************************/
 
-    if (!waitForEvent(&NRF_CCM->EVENTS_ENDCRYPT))
+uint8_t nrf_to_nrf::ccmFinish()
+{
+
+    if (!ccmBusy) {
+        return 0;
+    }
+    ccmBusy = false;
+
+    if (!waitForEvent(&NRF_CCM->EVENTS_ENDCRYPT)) {
         return 0;
+    }
 
     if (NRF_CCM->EVENTS_ERROR) {
         return 0;
     }
 
-    if (NRF_CCM->MICSTATUS == (CCM_MICSTATUS_MICSTATUS_CheckFailed << CCM_MICSTATUS_MICSTATUS_Pos)) {
+    if (ccmDecrypting && NRF_CCM->MICSTATUS == (CCM_MICSTATUS_MICSTATUS_CheckFailed << CCM_MICSTATUS_MICSTATUS_Pos)) {
         return 0;
     }
 
@@ -1444,18 +3635,151 @@ uint8_t nrf_to_nrf::decrypt(void* bufferIn, uint8_t size)
 
 /**********************************************************************************************************/
 
+bool nrf_to_nrf::takeIV(uint8_t* iv)
+{
+
+#if defined NRF_RNG_POOL
+    if (rngPoolCount < CCM_IV_SIZE) {
+        rngUnderruns++;
+        rngRefill();
+        uint32_t start = millis();
+        while (rngPoolCount < CCM_IV_SIZE) {
+            if (millis() - start > 100) {
+                return 0;
+            }
+        }
+    }
+    for (int i = 0; i < CCM_IV_SIZE; i++) {
+        iv[i] = rngPool[rngPoolHead];
+        rngPoolHead = (rngPoolHead + 1) % NRF_RNG_POOL_SIZE;
+    }
+    NVIC_DisableIRQ(RNG_IRQn);
+    rngPoolCount -= CCM_IV_SIZE;
+    NVIC_EnableIRQ(RNG_IRQn);
+    rngIVsTaken++;
+    rngRefill();
+#else
+    for (int i = 0; i < CCM_IV_SIZE; i++) {
+        if (!waitForEvent(&NRF_RNG->EVENTS_VALRDY, 100))
+            return 0;
+        NRF_RNG->EVENTS_VALRDY = 0;
+        iv[i] = NRF_RNG->VALUE;
+    }
+#endif
+    return 1;
+}
+
+/**********************************************************************************************************/
+
+#if defined NRF_RNG_POOL
+void nrf_to_nrf::rngRefill()
+{
+    // Bias correction makes each byte slow, so the RNG runs from its interrupt until the pool is full
+    NRF_RNG->INTENSET = RNG_INTENSET_VALRDY_Msk;
+    NRF_RNG->TASKS_START = 1;
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::handleRngIRQ()
+{
+    if (!NRF_RNG->EVENTS_VALRDY) {
+        return;
+    }
+    NRF_RNG->EVENTS_VALRDY = 0;
+
+    if (rngPoolCount < NRF_RNG_POOL_SIZE) {
+        rngPool[rngPoolTail] = NRF_RNG->VALUE;
+        rngPoolTail = (rngPoolTail + 1) % NRF_RNG_POOL_SIZE;
+        rngPoolCount++;
+        rngBytesGenerated++;
+    }
+    if (rngPoolCount >= NRF_RNG_POOL_SIZE) {
+        NRF_RNG->INTENCLR = RNG_INTENSET_VALRDY_Msk;
+        NRF_RNG->TASKS_STOP = 1;
+    }
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::getRngPoolStats(nrf_rng_pool_stats_t* stats)
+{
+    stats->size = NRF_RNG_POOL_SIZE;
+    stats->level = rngPoolCount;
+    stats->bytesGenerated = rngBytesGenerated;
+    stats->ivsTaken = rngIVsTaken;
+    stats->underruns = rngUnderruns;
+}
+
+/**********************************************************************************************************/
+#endif
+
+void nrf_to_nrf::getLinkStats(uint8_t pipe, nrf_link_stats_t* stats)
+{
+    memcpy(stats, &linkStats[pipe & 7], sizeof(nrf_link_stats_t));
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::resetLinkStats()
+{
+    memset(linkStats, 0, sizeof(linkStats));
+    memset(backoffStats, 0, sizeof(backoffStats));
+}
+
+/**********************************************************************************************************/
+
+#if defined NRF_CYCLE_STATS
+void nrf_to_nrf::addCycles(uint8_t stage, uint32_t cycles)
+{
+    cycleStats.stage[stage].count++;
+    cycleStats.stage[stage].cycles += cycles;
+    if (cycles > cycleStats.stage[stage].maxCycles) {
+        cycleStats.stage[stage].maxCycles = cycles;
+    }
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::getCycleStats(nrf_cycle_stats_t* stats)
+{
+    memcpy(stats, &cycleStats, sizeof(nrf_cycle_stats_t));
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::resetCycleStats()
+{
+    memset(&cycleStats, 0, sizeof(nrf_cycle_stats_t));
+}
+
+/**********************************************************************************************************/
+#endif
+
 void nrf_to_nrf::setKey(uint8_t key[CCM_KEY_SIZE])
 {
 
+    NRF_CCM->INPTR = (uint32_t)inBuffer;
+    NRF_CCM->OUTPTR = (uint32_t)outBuffer;
+    NRF_CCM->CNFPTR = (uint32_t)&ccmData;
+    NRF_CCM->SCRATCHPTR = (uint32_t)scratchPTR;
     NRF_CCM->MODE = 1 << 24 | 1 << 16;
     NRF_CCM->MAXPACKETSIZE = MAX_PACKET_SIZE;
     NRF_CCM->SHORTS = 1;
     NRF_CCM->ENABLE = 2;
 
     NRF_RNG->CONFIG = 1;
+#if defined NRF_RNG_POOL
+    rngInstance = this;
+    NVIC_EnableIRQ(RNG_IRQn);
+    rngRefill();
+#else
     NRF_RNG->TASKS_START = 1;
+#endif
 
     memcpy(ccmData.key, key, CCM_KEY_SIZE);
+    // Counters from a different key are unrelated
+    memset(replayWindows, 0, sizeof(replayWindows));
 }
 
 /**********************************************************************************************************/
@@ -1468,6 +3792,55 @@ void nrf_to_nrf::setCounter(uint64_t counter)
 }
 /**********************************************************************************************************/
 
+void nrf_to_nrf::setReplayProtection(bool enable)
+{
+    replayProtection = enable;
+    memset(replayWindows, 0, sizeof(replayWindows));
+}
+
+/**********************************************************************************************************/
+
+bool nrf_to_nrf::replayCheck(uint8_t pipe, uint32_t counter)
+{
+    replayWindow_t* window = &replayWindows[pipe];
+    if (!replayProtection || !window->valid) {
+        return true;
+    }
+    // Counters wrap, anything up to half the counter range ahead of the window is new
+    uint32_t ahead = (counter - window->top) & CCM_COUNTER_MASK;
+    if (ahead && ahead <= (CCM_COUNTER_MASK >> 1)) {
+        return true;
+    }
+    uint32_t behind = (window->top - counter) & CCM_COUNTER_MASK;
+    return behind < 32 && !(window->bitmap & (1UL << behind));
+}
+
+/**********************************************************************************************************/
+
+void nrf_to_nrf::replayAccept(uint8_t pipe, uint32_t counter)
+{
+    replayWindow_t* window = &replayWindows[pipe];
+    if (!replayProtection) {
+        return;
+    }
+    if (!window->valid) {
+        window->top = counter;
+        window->bitmap = 1;
+        window->valid = true;
+        return;
+    }
+    uint32_t ahead = (counter - window->top) & CCM_COUNTER_MASK;
+    if (ahead && ahead <= (CCM_COUNTER_MASK >> 1)) {
+        window->bitmap = ahead < 32 ? (window->bitmap << ahead) | 1 : 1;
+        window->top = counter;
+    }
+    else {
+        window->bitmap |= 1UL << ((window->top - counter) & CCM_COUNTER_MASK);
+    }
+}
+
+/**********************************************************************************************************/
+
 void nrf_to_nrf::setIV(uint8_t IV[CCM_IV_SIZE])
 {
 
@@ -17,15 +17,149 @@
 #endif
 
 #define NRF52_RADIO_LIBRARY
+#define NRF_RADIO_SHADOW_REGS      19 // Radio registers kept across powerDown()
+#define NRF_PROFILE_REGS           14 // Leading radioShadowRegs held by a nrf_radio_profile_t
 #define DEFAULT_MAX_PAYLOAD_SIZE   32
 #define ACTUAL_MAX_PAYLOAD_SIZE    258
-#define ACK_TIMEOUT_1MBPS          600 // 300 with static payloads
-#define ACK_TIMEOUT_2MBPS          400 // 265 with static payloads
-#define ACK_TIMEOUT_250KBPS        800 // 500 with staticPayloads
-#define ACK_TIMEOUT_1MBPS_OFFSET   300
-#define ACK_TIMEOUT_2MBPS_OFFSET   135
-#define ACK_TIMEOUT_250KBPS_OFFSET 300
-#define ACK_PAYLOAD_TIMEOUT_OFFSET 750
+#define RAMP_UP_FAST_US            40
+#define RAMP_UP_DEFAULT_US         130
+
+// ACK timeouts are derived from the airtime of the ACK (see nrf_airtime_us()) & the receiver's turnaround, plus this
+// margin in uS for jitter
+#ifndef NRF_ACK_TIMEOUT_MARGIN
+    #define NRF_ACK_TIMEOUT_MARGIN 30
+#endif
+
+// Worst case time in uS a receiver that ACKs in software (nRF54 or earlier versions of the library) takes from the end
+// of a packet until it ramps up to TX for the ACK. Those answer from available(), with dynamic payloads only after
+// decrypting the packet & loading any ACK payload, so these cover the ACK timeouts earlier versions used.
+#ifndef NRF_ACK_PEER_TURNAROUND
+    #define NRF_ACK_PEER_TURNAROUND 1200
+#endif
+#ifndef NRF_ACK_PEER_TURNAROUND_STATIC
+    #define NRF_ACK_PEER_TURNAROUND_STATIC 150
+#endif
+
+// Uncomment (or define via build flags) if every receiver runs this version of the library, so the ACK timeouts only
+// allow for its own turnaround (NRF_ACK_SW_TURNAROUND, or interframeSpacing with NRF_HW_ACK_TIMING) instead of
+// NRF_ACK_PEER_TURNAROUND
+//#define NRF_ACK_KNOWN_PEERS
+
+// Time in uS a receiver without hardware timed ACKs (NRF_HW_ACK_TIMING) takes to start its ACK after a packet,
+// not counting the TX ramp-up: the delay before the ACK is written plus the processing around it. Only used for the
+// ACK timeout with NRF_ACK_KNOWN_PEERS
+#ifndef NRF_ACK_SW_TURNAROUND
+    #define NRF_ACK_SW_TURNAROUND 120
+#endif
+
+// Number of received payloads that can be buffered before the radio stops accepting/ACKing new packets
+#ifndef NRF_RX_FIFO_SIZE
+    #define NRF_RX_FIFO_SIZE 3
+#endif
+
+// Number of payloads that can be queued with writeFast() or writeAsync()
+#ifndef NRF_TX_FIFO_SIZE
+    #define NRF_TX_FIFO_SIZE 3
+#endif
+
+// Number of ACK payloads that can be queued with writeAckPayload(), shared by all pipes like the nRF24 TX FIFO
+#ifndef NRF_ACK_FIFO_SIZE
+    #define NRF_ACK_FIFO_SIZE 3
+#endif
+
+// Maximum number of channels in a frequency hopping sequence, see enableHopping()
+#ifndef NRF_HOP_MAX_CHANNELS
+    #define NRF_HOP_MAX_CHANNELS 40
+#endif
+
+// A listening node that hears nothing for this many hop cycles waits on a single channel until it is back in sync
+#ifndef NRF_HOP_RESYNC_CYCLES
+    #define NRF_HOP_RESYNC_CYCLES 2
+#endif
+
+// Time in uS left for the receiver's hop clock error at the end of a slot, a packet & its ACK that would not fit
+// before the next hop wait for the next slot instead
+#ifndef NRF_HOP_GUARD_US
+    #define NRF_HOP_GUARD_US 100
+#endif
+
+// ACK turnaround on nRF52 is timed by the RADIO shorts plus a TIMER & PPI, both when sending (ACK timeout) and when
+// receiving (ACK sent interframeSpacing after the packet). begin() takes these over without checking for other users:
+//   NRF_ACK_TIMER          the timer, compare 0 & capture 1
+//   NRF_ACK_PPI_CH         4 consecutive PPI channels from this one
+//   NRF_ACK_PPI_GROUP      PPI group disabling the one-shot RADIO END (CRCOK while receiving) -> TIMER START channel
+//   NRF_ACK_PPI_RX_GROUP   PPI group disabling the one-shot RADIO DISABLED -> RXEN (TXEN for a late ACK) channel
+// Define these (via build flags) to move them, or define NRF_DISABLE_HW_ACK_TIMING to use the software timed ACK path
+#if !defined(ARDUINO_NRF54L15) && !defined(NRF_DISABLE_HW_ACK_TIMING)
+    #define NRF_HW_ACK_TIMING
+    #ifndef NRF_ACK_TIMER
+        #define NRF_ACK_TIMER NRF_TIMER2
+    #endif
+    #ifndef NRF_ACK_PPI_CH
+        #define NRF_ACK_PPI_CH 10
+    #endif
+    #ifndef NRF_ACK_PPI_GROUP
+        #define NRF_ACK_PPI_GROUP 0
+    #endif
+    #ifndef NRF_ACK_PPI_RX_GROUP
+        #define NRF_ACK_PPI_RX_GROUP (NRF_ACK_PPI_GROUP + 1)
+    #endif
+    #if NRF_ACK_PPI_CH + 3 > 19 || NRF_ACK_PPI_GROUP > 5 || NRF_ACK_PPI_RX_GROUP > 5 || NRF_ACK_PPI_GROUP == NRF_ACK_PPI_RX_GROUP
+        #error "NRF_ACK_PPI_CH must leave 4 programmable PPI channels (0-19), NRF_ACK_PPI_GROUP & NRF_ACK_PPI_RX_GROUP 2 different groups (0-5)"
+    #endif
+#endif
+
+// Duty-cycled RX (startDutyCycle()) opens & closes its listen windows in hardware, so they stay on schedule while the
+// CPU sleeps. While it runs it uses:
+//   NRF_DUTY_RTC           an RTC on the 32.768kHz LFCLK, compares 0-3
+//   NRF_DUTY_PPI_CH        5 consecutive PPI channels from this one
+//   NRF_DUTY_PPI_GROUP     PPI group holding the window close channel, disabled when a packet arrives in the window
+#if !defined(ARDUINO_NRF54L15)
+    #define NRF_DUTY_CYCLE
+    #ifndef NRF_DUTY_RTC
+        #define NRF_DUTY_RTC NRF_RTC2
+    #endif
+    #ifndef NRF_DUTY_PPI_CH
+        #define NRF_DUTY_PPI_CH 14
+    #endif
+    #ifndef NRF_DUTY_PPI_GROUP
+        #define NRF_DUTY_PPI_GROUP 2
+    #endif
+    #ifndef NRF_DUTY_XO_LEAD_US
+        #define NRF_DUTY_XO_LEAD_US 600
+    #endif
+    #if NRF_DUTY_PPI_CH + 4 > 19 || NRF_DUTY_PPI_GROUP > 5
+        #error "NRF_DUTY_PPI_CH must leave 5 programmable PPI channels (0-19), NRF_DUTY_PPI_GROUP must be a group (0-5)"
+    #endif
+#endif
+
+// Uncomment (or define via build flags) to also stop the HFXO between duty cycle windows, it is then started
+// NRF_DUTY_XO_LEAD_US before each window. Not for boards that use the HFXO for anything else, ie: USB CDC
+//#define NRF_DUTY_STOP_HFXO
+
+#if defined NRF_HW_ACK_TIMING && defined NRF_DUTY_CYCLE
+    #if NRF_DUTY_PPI_CH <= NRF_ACK_PPI_CH + 3 && NRF_DUTY_PPI_CH + 4 >= NRF_ACK_PPI_CH
+        #error "NRF_DUTY_PPI_CH & NRF_ACK_PPI_CH overlap"
+    #endif
+    #if NRF_DUTY_PPI_GROUP == NRF_ACK_PPI_GROUP || NRF_DUTY_PPI_GROUP == NRF_ACK_PPI_RX_GROUP
+        #error "NRF_DUTY_PPI_GROUP is also an ACK timing group"
+    #endif
+#endif
+
+// Uncomment (or define via build flags) to receive & ACK packets from RADIO_IRQHandler instead of from available()
+// The library then owns the RADIO interrupt vector, so this cannot be combined with other users of the RADIO peripheral
+//#define NRF_RADIO_IRQ_ENABLED
+// NVIC priority of the RADIO interrupt, 0 being the highest. The HW ACK turnaround moves on from it, so it should not
+// wait behind long running handlers. 2 is the highest one left to the application by the SoftDevice
+#if defined NRF_RADIO_IRQ_ENABLED && !defined NRF_RADIO_IRQ_PRIORITY
+    #define NRF_RADIO_IRQ_PRIORITY 2
+#endif
+
+// Define NRF_CYCLE_STATS (via build flags) to count the CPU cycles spent in each stage of write() & the RX path
+// The DWT cycle counter is used unless NRF_CYCLE_CLOCK() is defined to read another clock, ie: on a host build
+#if defined NRF_CYCLE_STATS && !defined NRF_CYCLE_CLOCK
+    #define NRF_CYCLE_CLOCK() (DWT->CYCCNT)
+#endif
 
 // AES CCM ENCRYPTION
 #if defined NRF_CCM || defined(DOXYGEN)
@@ -37,11 +171,22 @@
     #define CCM_IV_SIZE              5
     #define CCM_IV_SIZE_ACTUAL       8
     #define CCM_COUNTER_SIZE         3
+    #define CCM_COUNTER_MASK         (0xFFFFFFFFUL >> (8 * (4 - CCM_COUNTER_SIZE))) // The counter wraps at its field size
     #define CCM_MIC_SIZE             4
     #define CCM_START_SIZE           3
     #define CCM_MODE_LENGTH_EXTENDED 16
 #endif
 
+// Uncomment (or define via build flags) to generate the random bytes for the CCM IVs in the background into a pool of
+// NRF_RNG_POOL_SIZE bytes, instead of polling the RNG for every IV. The library then owns the RNG_IRQHandler vector
+//#define NRF_RNG_POOL
+#if defined NRF_RNG_POOL && (!defined CCM_ENCRYPTION_ENABLED || defined ARDUINO_NRF54L15)
+    #undef NRF_RNG_POOL
+#endif
+#if defined NRF_RNG_POOL && !defined NRF_RNG_POOL_SIZE
+    #define NRF_RNG_POOL_SIZE 32
+#endif
+
 typedef enum
 {
     /**
@@ -115,6 +260,238 @@ typedef enum
     NRF_CRC_24
 } nrf_crclength_e;
 
+/**
+ *
+ *
+ * The state of the last payload passed to nrf_to_nrf::writeAsync()
+ * @see
+ * - nrf_to_nrf::writeAsync()
+ * - nrf_to_nrf::txStatus()
+ *
+ */
+typedef enum
+{
+    /** (0) represents the payload was sent & ACKed (if ACKs are enabled) */
+    NRF_TX_SUCCESS = 0,
+    /** (1) represents all retries were used without receiving an ACK */
+    NRF_TX_FAILED,
+    /** (2) represents the payload is still being transmitted or waiting for an ACK */
+    NRF_TX_BUSY
+} nrf_tx_status_e;
+
+/**
+ * How long to wait before each retransmission, see nrf_to_nrf::setBackoff(). D is the setRetries() delay,
+ * 258uS * (delay setting)
+ */
+typedef enum
+{
+    /** (0) wait D before every retry, like the nRF24 */
+    NRF_BACKOFF_FIXED = 0,
+    /** (1) wait a random time from 0 to 2 * D, so nodes that collided retry apart */
+    NRF_BACKOFF_RANDOM,
+    /** (2) wait a random time from 0 to D * 2^n on the nth retry, n stops growing at the cap */
+    NRF_BACKOFF_EXPONENTIAL
+} nrf_backoff_e;
+
+#define NRF_BACKOFF_POLICIES 3
+
+/**
+ * Airtime in uS of a packet: 8-bit preamble, address, S0/LENGTH/S1 fields, payload & CRC
+ * @param kbps The data rate in kbps
+ * @param addressWidth The full address width in bytes, including the prefix (see setAddressWidth())
+ * @param headerBits The S0, LENGTH & S1 field lengths in bits
+ * @param payloadSize The payload length in bytes
+ * @param crcLength The CRC length in bytes
+ */
+constexpr uint32_t nrf_airtime_us(uint16_t kbps, uint8_t addressWidth, uint8_t headerBits, uint16_t payloadSize, uint8_t crcLength)
+{
+    return ((8UL + addressWidth * 8UL + headerBits + (payloadSize + crcLength) * 8UL) * 1000UL + kbps - 1) / kbps;
+}
+
+/**
+ * Per pipe link statistics, see getLinkStats()
+ *
+ * Received packets & RX errors are counted against the pipe they were received on, transmissions & ACKs against the
+ * pipe they were sent to.
+ */
+typedef struct
+{
+    /** Packets received & queued for reading */
+    uint32_t rxPackets;
+    /** Packets received with a CRC error, including ACKs */
+    uint32_t rxCrcErrors;
+    /** Retransmitted packets dropped as duplicates */
+    uint32_t rxDuplicates;
+    /** Packets & ACK payloads that failed decryption */
+    uint32_t rxDecryptFailures;
+    /** Packets received while the RX FIFO was full, held back until a slot is free, & ACK payloads dropped for the same reason */
+    uint32_t rxFifoFull;
+    /** Payloads sent successfully, ACKed or sent without requesting an ACK */
+    uint32_t txPackets;
+    /** Payloads that failed after all retries */
+    uint32_t txFailures;
+    /** Retransmissions */
+    uint32_t txRetransmits;
+    /** Attempts where no ACK was received before the timeout */
+    uint32_t txAckTimeouts;
+    /** Encrypted packets rejected by the replay window, see setReplayProtection() */
+    uint32_t rxReplays;
+    /** Attempts deferred because the channel was busy, see setListenBeforeTalk() */
+    uint32_t txCcaBusy;
+} nrf_link_stats_t;
+
+/**
+ * Retry delay statistics of one backoff policy, see nrf_to_nrf::getBackoffStats()
+ */
+typedef struct
+{
+    /** Retry delays waited */
+    uint32_t backoffs;
+    /** Total time spent in retry delays, uS */
+    uint32_t backoffTime;
+    /** Payloads that were delivered after at least one retry delay */
+    uint32_t recovered;
+    /** Payloads that failed after waiting out their retry delays */
+    uint32_t failed;
+} nrf_backoff_stats_t;
+
+/**
+ * Signal level measured on one channel by scanChannels(). Like getRSSI(), values are the magnitude of a negative
+ * dBm figure, so lower values mean a stronger signal
+ */
+typedef struct
+{
+    /** Strongest sample, -dBm */
+    uint8_t peak;
+    /** Average of the samples, -dBm */
+    uint8_t average;
+} nrf_scan_result_t;
+
+/**
+ * Last packet accepted on a pipe, to drop retransmissions. Kept per profile, see nrf_radio_profile_t
+ */
+typedef struct
+{
+    uint16_t crc; // RXCRC, or a checksum of the frame with CRC disabled
+    uint8_t pid;
+    bool valid;
+} nrf_dedup_entry_t;
+
+#if defined CCM_ENCRYPTION_ENABLED || defined(DOXYGEN)
+/**
+ * Counters accepted on a pipe with replay protection. Kept per profile, see nrf_radio_profile_t
+ */
+typedef struct
+{
+    uint32_t top;    // Highest counter accepted
+    uint32_t bitmap; // Bit n set if top - n was accepted
+    bool valid;
+} nrf_replay_window_t;
+#endif
+
+/**
+ * A complete link configuration, captured by nrf_to_nrf::saveProfile() & switched to by nrf_to_nrf::applyProfile().
+ * The fields are filled by saveProfile(), don't set them directly
+ */
+typedef struct
+{
+    uint32_t regs[NRF_PROFILE_REGS]; // Radio register image: packet format, addresses, CRC, data rate, PA, channel
+    uint32_t rxBase;
+    uint32_t rxPrefix;
+    uint32_t txBase;
+    uint32_t txPrefix;
+    uint16_t interframeSpacing;
+    uint8_t staticPayloadSize;
+    uint8_t acksPerPipe; // Bit n set if pipe n is auto-acked
+    uint8_t retries;
+    uint8_t retryDuration;
+    bool dpl;
+    bool ackPayloads;
+    bool dynamicAck;
+    bool valid;
+#if defined CCM_ENCRYPTION_ENABLED
+    bool encryption;
+    uint8_t key[CCM_KEY_SIZE];
+#endif
+    nrf_dedup_entry_t lastPacket[8]; // Receive state of the link, saved & restored by applyProfile()
+#if defined CCM_ENCRYPTION_ENABLED
+    nrf_replay_window_t replayWindows[8];
+#endif
+} nrf_radio_profile_t;
+
+#if defined NRF_CYCLE_STATS || defined(DOXYGEN)
+/**
+ *
+ *
+ * The stages of write() & the RX path that are timed when NRF_CYCLE_STATS is defined
+ * @see
+ * - nrf_to_nrf::getCycleStats()
+ *
+ */
+typedef enum
+{
+    /** (0) the whole write() call */
+    NRF_STAGE_WRITE = 0,
+    /** (1) taking an IV from the RNG (pool) */
+    NRF_STAGE_IV,
+    /** (2) encrypting the payload */
+    NRF_STAGE_ENCRYPT,
+    /** (3) copying the payload into the TX FIFO */
+    NRF_STAGE_COPY,
+    /** (4) waiting for TXIDLE & sending the packet, until the END event */
+    NRF_STAGE_TX,
+    /** (5) waiting for the ACK, or the ACK timeout */
+    NRF_STAGE_ACK_WAIT,
+    /** (6) the delay between retries */
+    NRF_STAGE_RETRY_DELAY,
+    /** (7) startListening() & stopListening(), the DISABLE waits & ramp-up */
+    NRF_STAGE_MODE_SWITCH,
+    /** (8) handling a received packet, from the CRCOK event to queuing it */
+    NRF_STAGE_RX,
+    /** (9) sending the ACK for a received packet */
+    NRF_STAGE_RX_ACK,
+    /** (10) waiting for the decryption of a received packet */
+    NRF_STAGE_DECRYPT,
+    /** (11) number of stages */
+    NRF_STAGE_COUNT
+} nrf_cycle_stage_e;
+
+/**
+ * CPU cycles spent in each stage, see getCycleStats()
+ */
+typedef struct
+{
+    struct
+    {
+        /** Number of times the stage ran */
+        uint32_t count;
+        /** Total cycles */
+        uint64_t cycles;
+        /** Longest single run in cycles */
+        uint32_t maxCycles;
+    } stage[NRF_STAGE_COUNT];
+} nrf_cycle_stats_t;
+#endif
+
+#if defined NRF_RNG_POOL || defined(DOXYGEN)
+/**
+ * Statistics for the background random byte pool used for CCM IVs, see getRngPoolStats()
+ */
+typedef struct
+{
+    /** Size of the pool in bytes (NRF_RNG_POOL_SIZE) */
+    uint8_t size;
+    /** Number of random bytes currently in the pool */
+    uint8_t level;
+    /** Total random bytes generated into the pool */
+    uint32_t bytesGenerated;
+    /** Total IVs taken from the pool */
+    uint32_t ivsTaken;
+    /** Number of times an IV was requested with too few bytes in the pool, so the TX path had to wait */
+    uint32_t underruns;
+} nrf_rng_pool_stats_t;
+#endif
+
 /**
  *
  * @brief Driver class for nRF52840 2.4GHz Wireless Transceiver
@@ -155,6 +532,10 @@ public:
 
     /**
      * Same as NRF24 radio.available();
+     *
+     * If NRF_RADIO_IRQ_ENABLED is defined, incoming packets are copied, ACKed and the radio restarted from the
+     * RADIO interrupt, so this only checks the RX FIFO. Packets answered with a software timed ACK (static payloads,
+     * or without NRF_HW_ACK_TIMING) are left to this instead, as sending the ACK blocks until it is on air
      */
     bool available(uint8_t* pipe_num);
 
@@ -163,6 +544,30 @@ public:
      */
     void read(void* buf, uint8_t len);
 
+    /**
+     * Returns the payload at the front of the RX FIFO without copying it
+     *
+     * Packets are received by EasyDMA straight into the RX FIFO slots, so the returned pointer stays valid
+     * until release() is called
+     * @code
+     * uint8_t len, pipe;
+     * const uint8_t* payload = radio.peek(&len, &pipe);
+     * if (payload) {
+     *   // use payload[0] ... payload[len - 1]
+     *   radio.release();
+     * }
+     * @endcode
+     * @param len Set to the length of the payload
+     * @param pipe Set to the pipe the payload was received on
+     * @return A pointer to the payload, or NULL if the RX FIFO is empty
+     */
+    const uint8_t* peek(uint8_t* len, uint8_t* pipe);
+
+    /**
+     * Removes the payload returned by peek() from the RX FIFO, freeing the slot for the radio
+     */
+    void release();
+
     /**
      * Same as NRF24 radio.write();
      */
@@ -175,7 +580,7 @@ public:
     void startListening(bool resetAddresses = true);
 
     /**
-     * Same as NRF24
+     * Same as NRF24, this also discards any queued ACK payloads
      * @param setWritingPipe Used internally
      * @param resetAddresses Used internally to reset addresses
      */
@@ -215,7 +620,11 @@ public:
     uint8_t radioData[ACTUAL_MAX_PAYLOAD_SIZE + 2];
 
     /**
-     * Not currently fully functional, calls the regular write();
+     * Same as NRF24, queues the payload in the TX FIFO and returns without waiting for it to be sent.
+     *
+     * Queued payloads are sent back-to-back, with ACKs & retries handled as the FIFO is serviced by
+     * writeFast(), available(), txStatus() or txStandBy(). Blocks while the TX FIFO is full.
+     * @return false if a previously queued payload failed, call txStandBy() to clear the failure
      */
     bool writeFast(void* buf, uint8_t len, bool multicast = 0);
 
@@ -224,16 +633,86 @@ public:
      *
      * This function will not wait for the radio to finish transmitting or for an ACK
      *
-     * Call txStandBy() to take the radio out of TX state or call startListening() to go into RX mode
+     * Call txStandBy() to take the radio out of TX state or call startListening() to go into RX mode, the payload
+     * holds a TX FIFO slot until it has been sent
      *
+     * @return false while an earlier payload is still being sent, see txStatus()
      */
     bool startWrite(void* buf, uint8_t len, bool multicast, bool doEncryption = true);
 
     /**
-     * Same as NRF24
+     * Same as write() but returns as soon as the payload has been queued in the TX FIFO.
+     *
+     * The TX, ACK wait & retries are then run by a state machine which is advanced by txStatus() & available(), and
+     * by the radio events from the RADIO interrupt if NRF_RADIO_IRQ_ENABLED is defined. Retry delays & software ACK
+     * timeouts are only moved on by polling.
+     * Any ACK payload received is placed in the RX FIFO and can be retrieved with available() & read()
+     *
+     * @code
+     * if (radio.writeAsync(&payload, sizeof(payload))) {
+     *   while (radio.txStatus() == NRF_TX_BUSY) {
+     *     // do other work
+     *   }
+     * }
+     * @endcode
+     * @return false if the TX FIFO is full or the payload could not be prepared
+     */
+    bool writeAsync(void* buf, uint8_t len, bool multicast = false, bool doEncryption = true);
+
+    /**
+     * Advances a transmission started with writeAsync() and returns its state
+     * @return One of the values defined by @ref nrf_tx_status_e
+     */
+    nrf_tx_status_e txStatus();
+
+    /**
+     * Returns a pointer into the next free TX FIFO slot, after the space reserved for the packet header
+     * and the encryption IV/counter, so a payload can be built in place and sent with writeTxBuffer()
+     * @code
+     * uint8_t* frame = radio.getTxBuffer();
+     * if (frame) {
+     *   frame[0] = 1;
+     *   radio.writeTxBuffer(1);
+     * }
+     * @endcode
+     * @param doEncryption Must match the value passed to writeTxBuffer()
+     * @return NULL if the TX FIFO is full
+     */
+    uint8_t* getTxBuffer(bool doEncryption = true);
+
+    /**
+     * Same as write(), but sends the payload built in the buffer returned by getTxBuffer() without copying it
+     */
+    bool writeTxBuffer(uint8_t len, bool multicast = false, bool doEncryption = true);
+
+    /**
+     * Optional function called when a writeAsync() or write() completes, with the result and the number of retries used
+     *
+     * If NRF_RADIO_IRQ_ENABLED is defined, this is usually called from the RADIO interrupt
+     *
+     * @code
+     * void txDone(bool success, uint8_t arc) {}
+     * radio.txCallback = txDone;
+     * @endcode
+     */
+    void (*txCallback)(bool success, uint8_t arc);
+
+    /**
+     * Same as NRF24, queues a payload to be sent with the ACK for the next packet received on a pipe
+     *
+     * Up to NRF_ACK_FIFO_SIZE payloads can be queued, shared by all pipes, each pipe's payloads are sent in order.
+     * A payload stays queued until a new packet on its pipe shows it was delivered, so a retransmission after a lost
+     * ACK gets the same payload again. With encryption enabled the payload is encrypted here, not when it is sent.
+     * @return false if the queue is full
      */
     bool writeAckPayload(uint8_t pipe, void* buf, uint8_t len);
 
+    /**
+     * Number of ACK payloads queued for a pipe, including one that was sent & is waiting for the next packet to
+     * confirm it was delivered
+     */
+    uint8_t getAckPayloadCount(uint8_t pipe);
+
     /**
      * Same as NRF24
      */
@@ -271,6 +750,36 @@ public:
      */
     uint8_t getChannel();
 
+    /**
+     * Hop through a list of channels, in an order shuffled by @p seed, staying @p dwellTime uS on each.
+     *
+     * Nodes with the same channel list & seed share the hop sequence. Data packets end with a byte giving the time
+     * into the sender's slot, a receiver aligns its own hop clock with it, so nodes stay in sync while they exchange
+     * packets. A listening node that hears nothing for NRF_HOP_RESYNC_CYCLES cycles waits on one channel until the
+     * sender comes by, so links recover after losing sync (resets, a long fade).
+     *
+     * Channels change from available() & when writing, listening nodes need to call available() regularly.
+     * @note Needs dynamic payloads, call enableDynamicPayloads() first. The extra byte reduces the maximum payload size
+     * by one (writes of a full size payload return false), and all the nodes on the link must be hopping
+     * @param channels Channels as for setChannel(), 0 to 100
+     * @param count Number of channels, up to NRF_HOP_MAX_CHANNELS
+     * @param seed Seed for the hop sequence, the same on every node
+     * @param dwellTime Time on each channel in uS, it should allow several packets, ACKs & retries
+     * @return false if dynamic payloads are disabled or the parameters are invalid
+     */
+    bool enableHopping(const uint8_t* channels, uint8_t count, uint32_t seed, uint32_t dwellTime);
+
+    /**
+     * Stop hopping, the radio stays on the current channel
+     */
+    void disableHopping();
+
+    /**
+     * @return true while hopping in sync with the other nodes, ie: a packet was received or ACKed within the last
+     * NRF_HOP_RESYNC_CYCLES hop cycles
+     */
+    bool isHopSynchronized();
+
     /**
      * Supported speeds: NRF_250KBPS NRF_1MBPS NRF_2MBPS - NRF54x ONLY: NRF_4MBPS_OBT4 NRF_4MBPS_OBT6
      */
@@ -354,6 +863,22 @@ public:
      */
     void setRetries(uint8_t retryVar, uint8_t attempts);
 
+    /**
+     * Choose how long to wait before each retransmission, see @ref nrf_backoff_e. With the fixed delay of the nRF24,
+     * nodes whose packets collided retry at the same time & collide again, random delays spread them out.
+     * The random delays are drawn from a generator seeded by the RNG peripheral.
+     * @param policy NRF_BACKOFF_FIXED (default), NRF_BACKOFF_RANDOM or NRF_BACKOFF_EXPONENTIAL
+     * @param cap Largest exponent of NRF_BACKOFF_EXPONENTIAL, 0-15: the delay is at most D * 2^cap
+     */
+    void setBackoff(nrf_backoff_e policy, uint8_t cap = 5);
+
+    /**
+     * Get the retry delay statistics of a backoff policy, counted while it was selected
+     * @param policy The policy to read
+     * @param stats Filled with a copy of the counters
+     */
+    void getBackoffStats(nrf_backoff_e policy, nrf_backoff_stats_t* stats);
+
     /**
      * Same as NRF24
      */
@@ -375,39 +900,92 @@ public:
     void printDetails();
 
     /**
-     * When powering up from powerdown ALL radio settings will need to be re-applied
+     * Enables the Radio & HF Clock, restoring the settings saved by powerDown()
      *
-     * Enables the Radio & HF Clock
+     * Returns without waiting for the HF Clock, the next startListening(), stopListening(), write or scan waits for
+     * what is left of its start-up instead
      *
      * If encryption is enabled, also enables RNG & CCM peripherals
      */
     void powerUp();
 
     /**
-     * When called ALL radio settings will be reverted to default
-     *
      * Disables the Radio & HF Clock
      *
-     * If encryption is enabled, also disables RNG & CCM peripherals
+     * The radio configuration (addresses, pipes, channel, data rate, PA level, CRC, payload settings) is saved
+     * first & restored by powerUp(), so it does not need to be re-applied. Settings changed while powered down are
+     * lost, apply them after powerUp()
+     *
+     * If encryption is enabled, also disables RNG & CCM peripherals, the key is kept
      */
     void powerDown();
 
+    /**
+     * Duty-cycled receive: listen for @p window uS every @p period uS, with the radio & HFXO off in between.
+     *
+     * Windows are opened & closed by an RTC & PPI channels (see NRF_DUTY_RTC), so they stay on schedule while the
+     * CPU sleeps. A window in which a packet arrived is closed by available() instead, once the packet & its ACK are
+     * done. Unlike powerDown(), the radio keeps all its settings between windows. Senders reach a duty-cycled node by
+     * re-sending for at least one period, ie: `radio.writeFast(buf, len); radio.txStandBy(period / 1000 + 1);`
+     *
+     * Call after startListening(), stopListening() ends duty cycling.
+     * @note Not available on NRF54x. Cannot be combined with enableHopping(). The HFXO keeps running between
+     * windows unless NRF_DUTY_STOP_HFXO is defined
+     * @param window Listen time per period in uS, in steps of the 30.5uS RTC tick
+     * @param period Time from one window to the next in uS, up to 512 seconds
+     * @return false if not listening, hopping, or the window & the HFXO start-up don't fit in the period
+     */
+    bool startDutyCycle(uint32_t window, uint32_t period);
+
+    /**
+     * Stop duty cycling & listen continuously again
+     */
+    void stopDutyCycle();
+
+    /**
+     * Capture the current link configuration into @p profile, to switch back to it later with applyProfile()
+     *
+     * Configure the radio as usual (channel, data rate, PA level, CRC, payload size or dynamic payloads, auto-ack,
+     * ACK payloads, retries, pipes & key), then save it. Repeat for each network a node alternates between.
+     * Frequency hopping, duty cycling, listen-before-talk & the backoff policy are not part of a profile.
+     * The saved profile becomes the active one & keeps the duplicate/replay detection state from then on, so profiles
+     * must stay in memory (ex: globals) while in use.
+     * @note Not available on NRF54x, returns false
+     * @return false if the profile could not be captured
+     */
+    bool saveProfile(nrf_radio_profile_t* profile);
+
+    /**
+     * Switch to a configuration captured by saveProfile()
+     *
+     * The register image & driver state are copied in one pass and the radio is restarted in its current mode
+     * (listening or not), so the switch costs little more than one radio ramp-up. The duplicate & replay detection
+     * state of the active profile is saved into it and @p profile's is restored, so switching back & forth doesn't
+     * accept retransmissions or replays again. Queued ACK payloads are dropped, packets already in the RX FIFO are
+     * kept & should be read before switching if their pipe numbers matter.
+     * @note Not available on NRF54x, returns false
+     * @return false if a transmission is in progress, hopping or duty cycling is enabled, or the profile is not valid
+     */
+    bool applyProfile(nrf_radio_profile_t* profile);
+
     /**
      * Not implemented due to SOC
      */
     bool failureDetected;
 
     /**
-     * Takes the radio out of TX state.
+     * Same as NRF24, waits for the TX FIFO to empty
      *
-     * Can be called after any type of write to put the radio into a disabled state
+     * @return true if every queued payload was sent successfully
      */
     bool txStandBy();
 
     /**
-     * Takes the radio out of TX state
+     * Same as NRF24, waits for the TX FIFO to empty, re-sending failed payloads until @p timeout (ms) expires
      *
-     * Can be called after any type of write to put the radio into a disabled state
+     * After the timeout, the attempt on air is allowed to finish & anything left in the TX FIFO is dropped
+     * @param startTx Not used, added for backward compatibility
+     * @return true if every queued payload was sent successfully
      */
     bool txStandBy(uint32_t timeout, bool startTx = 0);
 
@@ -430,16 +1008,59 @@ public:
      */
     uint8_t getRSSI();
 
+    /**
+     * The RSSI of the last payload read with read() (or release()), sampled by the radio as the packet's address
+     * was received, so there is no waiting. ACK payloads carry the RSSI of the ACK.
+     * @note Not available on NRF54x, returns 0
+     * @return The RSSI in the same units as getRSSI(): received signal strength = -A dBm
+     */
+    uint8_t getPacketRSSI();
+
+    /**
+     * Measure the signal level on a range of channels, ie: to pick a quiet channel or exclude busy ones from hopping.
+     *
+     * The receiver is re-enabled on each channel by the RADIO shorts, with the fast ramp-up, so a sweep of the 101
+     * channels with 4 RSSI samples each takes a few mS. Nothing is received during the scan, the radio is
+     * returned to the channel & mode it was in.
+     * @note Not available on NRF54x, returns false
+     * @param firstChannel First channel to measure, 0 to 100
+     * @param lastChannel Last channel to measure, from firstChannel to 100
+     * @param results Array of lastChannel - firstChannel + 1 results, filled in channel order
+     * @param samples Number of samples taken on each channel
+     * @param energyDetect On chips with NRF_HAS_ENERGY_DETECT, take each sample with the energy detection, which
+     * averages over 128uS instead of sampling the RSSI once. Slower, but short bursts are not missed between samples
+     * @return false if a transmission is in progress or the radio did not respond
+     */
+    bool scanChannels(uint8_t firstChannel, uint8_t lastChannel, nrf_scan_result_t* results, uint8_t samples = 4, bool energyDetect = false);
+
+    /**
+     * Listen-before-talk: run a clear channel assessment (CCA) before each transmit attempt. The radio's shorts chain
+     * RX ramp-up -> CCA -> TX ramp-up -> START, so a clear channel costs one 128uS energy detection per attempt.
+     * When the energy is above the threshold the attempt is not sent, it counts as a retry and waits out the retry
+     * delay like a missing ACK, see nrf_link_stats_t::txCcaBusy. ACKs are always sent without CCA.
+     * @note Only on chips with NRF_HAS_ENERGY_DETECT (nRF52820/833/840), returns false otherwise
+     * @param enable true to assess the channel before each attempt
+     * @param threshold Energy level that makes the channel busy, in the same units as getRSSI(): -A dBm
+     * @return false if CCA is not available on this chip
+     */
+    bool setListenBeforeTalk(bool enable, uint8_t threshold = 65);
+
     /**
      * Same as NRF24
      */
     uint8_t getARC();
 
     /**
-     * Does nothing, added for backward compatibility
+     * Same as NRF24, empties the RX FIFO
      */
     uint8_t flush_rx();
 
+    /**
+     * Same as NRF24, empties the TX FIFO & the queued ACK payloads. A payload that is already on air is allowed to
+     * complete
+     */
+    uint8_t flush_tx();
+
     /**
      * The IEEE 802.15.4 standard defines a specific time that is alotted for the MAC sublayer to process received data.
      * Usage of this interframe spacing (IFS) comes into play to avoid that two frames are transmitted too close to
@@ -456,6 +1077,49 @@ public:
     uint8_t sample_ed(void);
 #endif
 
+    /**
+     * Get the link statistics of a pipe, see @ref nrf_link_stats_t
+     * @param pipe The pipe number 0-7
+     * @param stats Filled with a copy of the counters
+     */
+    void getLinkStats(uint8_t pipe, nrf_link_stats_t* stats);
+
+    /**
+     * Clear the link statistics of all pipes & the backoff statistics
+     */
+    void resetLinkStats();
+
+#if defined NRF_RADIO_IRQ_ENABLED
+    /**
+     * Used internally, called from RADIO_IRQHandler to handle received packets
+     */
+    void handleRadioIRQ();
+#endif
+
+#if defined NRF_RNG_POOL || defined(DOXYGEN)
+    /**
+     * Used internally, called from RNG_IRQHandler to refill the random byte pool
+     */
+    void handleRngIRQ();
+
+    /**
+     * Get the fill level & refill statistics of the random byte pool used for CCM IVs
+     */
+    void getRngPoolStats(nrf_rng_pool_stats_t* stats);
+#endif
+
+#if defined NRF_CYCLE_STATS || defined(DOXYGEN)
+    /**
+     * Get the cycle counts per stage (see @ref nrf_cycle_stage_e), only available if NRF_CYCLE_STATS is defined
+     */
+    void getCycleStats(nrf_cycle_stats_t* stats);
+
+    /**
+     * Clear the cycle counts
+     */
+    void resetCycleStats();
+#endif
+
     /**@}*/
     /**
      * @name Encryption
@@ -468,6 +1132,7 @@ public:
      * Used internally to convert addresses
      */
     uint32_t addrConv32(uint32_t addr);
+
 #if defined CCM_ENCRYPTION_ENABLED || defined(DOXYGEN)
 
     /**
@@ -496,9 +1161,25 @@ public:
 
     /**
      * Set the (default 3-byte) packet counter used for encryption
+     *
+     * With replay protection enabled on the receiving side, a sender that restarts its counter is rejected until
+     * the counter passes the last one received. Keep the counter across resets, or have the receiver reset its
+     * replay window.
      */
     void setCounter(uint64_t counter);
 
+    /**
+     * Reject encrypted packets that were already received, before spending time decrypting them
+     *
+     * Each pipe keeps the highest counter received & a 32-packet window below it. Packets with a counter that was
+     * already accepted or that is older than the window are dropped & counted in nrf_link_stats_t::rxReplays.
+     * A retransmission of the last packet, after a lost ACK, is still ACKed. The windows are reset when this is
+     * called, by setKey() and for a pipe by openReadingPipe().
+     *
+     * Disabled by default, see setCounter()
+     */
+    void setReplayProtection(bool enable);
+
     /**
      * Set IV for encryption.
      * This is only used for manual encryption, a random IV is generated using the on-board RNG for encryption
@@ -529,28 +1210,179 @@ private:
     bool acksPerPipe[8];
     uint8_t retries;
     uint8_t retryDuration;
-    uint8_t rxBuffer[ACTUAL_MAX_PAYLOAD_SIZE + 1];
-    uint8_t ackBuffer[ACTUAL_MAX_PAYLOAD_SIZE + 1];
-    uint8_t rxFifoAvailable;
+    nrf_backoff_e backoffPolicy;
+    uint8_t backoffCap;
+    uint32_t backoffState; // xorshift32, 0 until seeded
+    nrf_backoff_stats_t backoffStats[NRF_BACKOFF_POLICIES];
+    typedef struct
+    {
+        uint8_t frame[ACTUAL_MAX_PAYLOAD_SIZE + 2]; // Raw packet as written by EasyDMA, decrypted in place
+        uint8_t offset;
+        uint8_t length;
+        uint8_t pipe;
+        uint8_t rssi;
+    } rxFifoSlot_t;
+    rxFifoSlot_t rxFifo[NRF_RX_FIFO_SIZE];
+    volatile uint8_t rxFifoHead;
+    volatile uint8_t rxFifoTail;
+    volatile uint8_t rxFifoCount;
+    bool rxBusy;
+#if defined NRF_RADIO_IRQ_ENABLED
+    volatile bool rxAckDeferred; // A packet waits for available() to send its ACK
+#endif
+    uint8_t* rxFrame;
+    uint8_t rxLastRSSI; // RSSI of the last payload released
+    void rxArm();
+    typedef struct
+    {
+        uint8_t data[ACTUAL_MAX_PAYLOAD_SIZE]; // Already encrypted if encryption is enabled
+        uint8_t length;
+        uint8_t pipe;                          // ACK_SLOT_FREE if unused
+    } ackSlot_t;
+    ackSlot_t ackSlots[NRF_ACK_FIFO_SIZE];
+    uint8_t ackOrder[NRF_ACK_FIFO_SIZE]; // Queued slots, oldest first
+    uint8_t ackCount;
+    uint8_t ackSentPipes; // Pipes whose oldest payload went out with their last ACK
+    ackSlot_t* nextAckPayload(uint8_t pipe, bool retransmit);
+    void flushAckPayloads();
     bool DPL;
     bool ackPayloadsEnabled;
-    bool inRxMode;
+    volatile bool inRxMode;
     uint8_t staticPayloadSize;
     uint8_t ackPID;
-    uint8_t ackPipe;
     bool lastTxResult;
     uint32_t rxBase;
     uint32_t rxPrefix;
     uint32_t txBase;
     uint32_t txPrefix;
-    bool ackPayloadAvailable;
-    uint8_t ackAvailablePipeNo;
-    uint8_t lastPacketCounter;
-    uint16_t lastData;
+    typedef nrf_dedup_entry_t dedupEntry_t;
+    dedupEntry_t lastPacket[8]; // Last packet accepted on each pipe, to drop retransmissions
+    nrf_radio_profile_t* activeProfile; // Profile lastPacket & replayWindows belong to, see applyProfile()
+    void storeProfileState();
+    uint16_t frameChecksum(const uint8_t* frame, uint16_t length);
     bool dynamicAckEnabled;
     uint8_t arcCounter;
-    uint16_t ackTimeout;
-    bool payloadAvailable;
+    enum
+    {
+        TX_STAGE_IDLE = 0,
+        TX_STAGE_RAMP_UP,     // Waiting for TXIDLE, queued payloads are started back-to-back
+        TX_STAGE_CCA_DISABLE, // Listen-before-talk, waiting for DISABLED to start the CCA chain
+        TX_STAGE_CCA,         // Listen-before-talk, waiting for the frame's ADDRESS or CCABUSY
+        TX_STAGE_STARTING,    // HW timed ACK, waiting for ADDRESS to move PACKETPTR off the frame
+        TX_STAGE_SENDING,
+        TX_STAGE_WAIT_ACK,
+        TX_STAGE_RETRY_DELAY,
+        TX_STAGE_SENDING_NO_ACK // startWrite()
+    };
+    volatile uint8_t txStage;
+    typedef struct
+    {
+        uint8_t data[ACTUAL_MAX_PAYLOAD_SIZE + 2];
+        uint16_t length;
+        bool multicast;
+        bool doEncryption;
+        bool hopPhase; // Ends with the slot phase byte, see enableHopping()
+    } txFifoSlot_t;
+    txFifoSlot_t txFifo[NRF_TX_FIFO_SIZE];
+    uint8_t txFifoHead;
+    uint8_t txFifoTail;
+    uint8_t txFifoCount;
+    bool txFifoFailed;
+    bool txReuse;
+    uint8_t txAttempt;
+    uint8_t txPayloadSize;
+    uint32_t txRxAddresses;
+    uint32_t txTimer;
+    uint32_t txAckTimeout;
+    uint32_t txAckFrameTime;
+    bool txSendingAck;
+#ifdef NRF_HAS_ENERGY_DETECT
+    uint32_t txShorts; // Restored once the CCA chain has started the frame
+#endif
+    txFifoSlot_t ackFrame; // ACKs are sent from here, never from the TX FIFO slot handed out by getTxBuffer()
+    nrf_link_stats_t linkStats[8];
+    bool prepareTx(txFifoSlot_t* slot, void* buf, uint8_t len, bool multicast, bool doEncryption);
+    void txStartAttempt();
+    void txStartFrame();
+    void txStarted();
+    void updateTx();
+    void advanceTx();
+    void txRestoreRx();
+    void txComplete(bool success);
+    uint32_t ackWaitTime();
+    uint32_t frameAirtime(uint16_t length);
+    uint16_t dataRateKbps();
+    uint8_t txDataStart(bool doEncryption);
+#if defined NRF_HW_ACK_TIMING
+    bool txHwAck;
+    uint32_t rxShorts;
+    enum
+    {
+        RX_TURN_NONE = 0,
+        RX_TURN_ACK, // Waiting for READY, the ACK has started & PACKETPTR is free for the next RX slot
+        RX_TURN_RX   // Waiting for RXREADY after the ACK or a dropped packet
+    };
+    volatile uint8_t rxTurn;
+    bool rxAckArmed;       // The next CRCOK starts the ACK timer
+    bool rxAckStaged;      // The ACK frame is in place before the packet, see stageHwAck()
+    uint8_t rxAckPipe;     // Pipe the staged ACK is for
+    ackSlot_t* rxAckSlot;  // ACK payload the staged ACK carries
+    uint32_t ackTxAddress; // TXADDRESS to restore once the ACK is on air
+    void sendHwAck(uint8_t pipe, bool retransmit);
+    void loadHwAck(uint8_t pipe, ackSlot_t* ack);
+    void stageHwAck();
+    void restageHwAck();
+    bool hwAckTaken();
+    void hwAckReturn();
+    void hwAckUpdate();
+    void hwAckFinish();
+    void setupAckTimer();
+    void armAckTimer(uint32_t timeout);
+    void armAckTurnaround();
+    void disarmAckTimer();
+#endif
+#if defined NRF_CYCLE_STATS
+    nrf_cycle_stats_t cycleStats;
+    uint32_t txStageStart;
+    void addCycles(uint8_t stage, uint32_t cycles);
+#endif
+    uint8_t hopChannels[NRF_HOP_MAX_CHANNELS]; // Shuffled hop sequence
+    uint8_t hopCount;                          // 0 when not hopping
+    uint32_t hopDwell;
+    uint32_t hopSlotStart;  // micros() at the start of the current slot
+    uint8_t hopIndex;       // Current slot of the hop sequence
+    uint8_t hopTunedIndex;  // Slot the radio is tuned to, HOP_NOT_TUNED if none
+    uint8_t hopParkIndex;   // Slot listened on while out of sync
+    bool hopParked;
+    uint32_t hopIdleSlots;  // Slots since a packet was received or ACKed
+    void hopUpdate();
+    void hopListen();
+    void hopRetuneTx(txFifoSlot_t* slot);
+    void hopSync(uint8_t phase, uint32_t rxTime, uint8_t length);
+    uint8_t hopPhase(uint32_t delay = 0);
+    uint8_t ccaThreshold; // EDSAMPLE units, 0 when listen-before-talk is off
+    bool txChannelBusy();
+    uint32_t txBackoff;   // Current retry delay, uS
+    bool txBackedOff;     // The payload being sent waited out at least one retry delay
+    void txRetryDelay();
+    uint32_t backoffRandom();
+#if defined NRF_DUTY_CYCLE
+    uint32_t dutyWindowTicks; // 0 when not duty cycling
+    uint32_t dutyShorts;      // Listening shorts, READY_START is added while the window is closed
+    uint32_t dutyHoldTime;
+    bool dutyOpen;
+    bool dutyHold; // A packet started after the window ended
+    void dutyUpdate();
+    bool dutyClosedByRtc();
+    void dutyDisarm();
+#endif
+    bool clockPending; // powerUp() did not wait for the HF Clock yet
+    void clockReady();
+#if !defined(ARDUINO_NRF54L15)
+    uint32_t radioShadow[NRF_RADIO_SHADOW_REGS]; // Registers saved by powerDown(), see radioShadowRegs
+    uint32_t radioShadowInten;
+#endif
+    bool processRxPacket();
     bool restartReturnRx();
     void openReadingPipe(uint8_t child, uint32_t base, uint32_t prefix);
     void openWritingPipe(uint32_t base, uint32_t prefix);
@@ -566,6 +1398,26 @@ private:
     } ccmData_t;
     ccmData_t ccmData;
     uint32_t packetCounter;
+    typedef nrf_replay_window_t replayWindow_t;
+    replayWindow_t replayWindows[8];
+    bool replayProtection;
+    bool replayCheck(uint8_t pipe, uint32_t counter);
+    void replayAccept(uint8_t pipe, uint32_t counter);
+    bool ccmBusy;
+    bool ccmDecrypting;
+    void ccmStart(uint8_t* data, uint8_t size, bool decrypt);
+    uint8_t ccmFinish();
+    bool takeIV(uint8_t* iv);
+    #if defined NRF_RNG_POOL
+    uint8_t rngPool[NRF_RNG_POOL_SIZE];
+    uint8_t rngPoolHead;
+    uint8_t rngPoolTail;
+    volatile uint8_t rngPoolCount;
+    volatile uint32_t rngBytesGenerated;
+    uint32_t rngIVsTaken;
+    uint32_t rngUnderruns;
+    void rngRefill();
+    #endif
 #endif
 };
 